@@ -45,10 +45,10 @@ int64_t AttackPossibility::attackValue() const
 
 AttackPossibility AttackPossibility::evaluate(const BattleAttackInfo & attackInfo, BattleHex hex)
 {
-	const std::string cachingStringBlocksRetaliation = "type_BLOCKS_RETALIATION";
+	static const auto cachingKeyBlocksRetaliation = BonusCacheKey::type(Bonus::BLOCKS_RETALIATION);
 	static const auto selectorBlocksRetaliation = Selector::type(Bonus::BLOCKS_RETALIATION);
 
-	const bool counterAttacksBlocked = attackInfo.attacker->hasBonus(selectorBlocksRetaliation, cachingStringBlocksRetaliation);
+	const bool counterAttacksBlocked = attackInfo.attacker->hasBonus(selectorBlocksRetaliation, cachingKeyBlocksRetaliation);
 
 	AttackPossibility ap(hex, attackInfo);
 
@@ -16,7 +16,7 @@
 #include "EnemyInfo.h"
 #include "PossibleSpellcast.h"
 #include "../../lib/CStopWatch.h"
-#include "../../lib/CThreadHelper.h"
+#include "../../lib/CThreadPool.h"
 #include "../../lib/spells/CSpellHandler.h"
 #include "../../lib/spells/ISpellMechanics.h"
 #include "../../lib/CStack.h"//todo: remove
@@ -413,9 +413,11 @@ void CBattleAI::attemptCastingSpell()
 		}
 	}
 
-	auto evaluateSpellcast = [&] (PossibleSpellcast * ps)
+	const HypotheticBattle initialState(cb);
+
+	auto evaluateSpellcast = [&] (PossibleSpellcast * ps, std::shared_ptr<HypotheticBattle> fork)
 	{
-		HypotheticBattle state(cb);
+		HypotheticBattle & state = *fork;
 
 		spells::BattleCast cast(&state, hero, spells::Mode::HERO, ps->spell);
 		cast.target = ps->dest;
@@ -481,20 +483,15 @@ void CBattleAI::attemptCastingSpell()
 	std::vector<std::function<void()>> tasks;
 
 	for(PossibleSpellcast & psc : possibleCasts)
-		tasks.push_back(std::bind(evaluateSpellcast, &psc));
-
-	uint32_t threadCount = boost::thread::hardware_concurrency();
-
-	if(threadCount == 0)
 	{
-		logGlobal->warn("No information of CPU cores available");
-		threadCount = 1;
+		//forks are evaluated on pool threads, so they must not share unit states
+		auto fork = std::make_shared<HypotheticBattle>(initialState.detachedCopy());
+		tasks.push_back(std::bind(evaluateSpellcast, &psc, fork));
 	}
 
 	CStopWatch timer;
 
-	CThreadHelper threadHelper(&tasks, threadCount);
-	threadHelper.run();
+	CThreadPool::get().run(tasks);
 
 	LOGFL("Evaluation took %d ms", timer.getDiff());
 
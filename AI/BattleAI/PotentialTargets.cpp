@@ -13,8 +13,9 @@
 
 PotentialTargets::PotentialTargets(const battle::Unit * attacker, const HypotheticBattle * state)
 {
-	auto attIter = state->stackStates.find(attacker->unitId());
-	const battle::Unit * attackerInfo = (attIter == state->stackStates.end()) ? attacker : attIter->second.get();
+	const battle::Unit * attackerInfo = state->getUnitState(attacker->unitId());
+	if(!attackerInfo)
+		attackerInfo = attacker;
 
 	auto reachability = state->getReachability(attackerInfo);
 	auto avHexes = state->battleGetAvailableHexes(reachability, attackerInfo);
@@ -23,10 +23,32 @@ void actualizeEffect(TBonusListPtr target, const Bonus & ef)
 	}
 }
 
+HypotheticEnvironment::HypotheticEnvironment(std::shared_ptr<CBattleInfoCallback> realBattle_)
+	: realBattle(realBattle_)
+{
+}
+
+bool HypotheticEnvironment::unitHasAmmoCart(const battle::Unit * unit) const
+{
+	//FIXME: check ammocart alive state here
+	return false;
+}
+
+PlayerColor HypotheticEnvironment::unitEffectiveOwner(const battle::Unit * unit) const
+{
+	return realBattle->battleGetOwner(unit);
+}
+
+int64_t HypotheticEnvironment::getTreeVersion() const
+{
+	return realBattle->getBattleNode()->getTreeVersion();
+}
+
 StackWithBonuses::StackWithBonuses(const HypotheticBattle * Owner, const CStack * Stack)
 	: battle::CUnitState(),
 	origBearer(Stack),
-	owner(Owner),
+	environment(Owner->getEnvironment()),
+	bonusesVersion(CBonusSystemNode::nextTreeVersion()),
 	type(Stack->unitType()),
 	baseAmount(Stack->unitBaseAmount()),
 	id(Stack->unitId()),
@@ -34,7 +56,7 @@ StackWithBonuses::StackWithBonuses(const HypotheticBattle * Owner, const CStack
 	player(Stack->unitOwner()),
 	slot(Stack->unitSlot())
 {
-	localInit(Owner);
+	localInit(environment.get());
 
 	battle::CUnitState::operator=(*Stack);
 }
@@ -42,7 +64,8 @@ StackWithBonuses::StackWithBonuses(const HypotheticBattle * Owner, const CStack
 StackWithBonuses::StackWithBonuses(const HypotheticBattle * Owner, const battle::UnitInfo & info)
 	: battle::CUnitState(),
 	origBearer(nullptr),
-	owner(Owner),
+	environment(Owner->getEnvironment()),
+	bonusesVersion(CBonusSystemNode::nextTreeVersion()),
 	baseAmount(info.count),
 	id(info.id),
 	side(info.side),
@@ -53,12 +76,32 @@ StackWithBonuses::StackWithBonuses(const HypotheticBattle * Owner, const battle:
 
 	player = Owner->getSidePlayer(side);
 
-	localInit(Owner);
+	localInit(environment.get());
 
 	position = info.position;
 	summoned = info.summoned;
 }
 
+StackWithBonuses::StackWithBonuses(const StackWithBonuses & other)
+	: battle::CUnitState(),
+	bonusesToAdd(other.bonusesToAdd),
+	bonusesToUpdate(other.bonusesToUpdate),
+	bonusesToRemove(other.bonusesToRemove),
+	origBearer(other.origBearer),
+	environment(other.environment),
+	bonusesVersion(other.bonusesVersion),
+	type(other.type),
+	baseAmount(other.baseAmount),
+	id(other.id),
+	side(other.side),
+	player(other.player),
+	slot(other.slot)
+{
+	localInit(environment.get());
+
+	battle::CUnitState::operator=(other);
+}
+
 StackWithBonuses::~StackWithBonuses() = default;
 
 StackWithBonuses & StackWithBonuses::operator=(const battle::CUnitState & other)
@@ -98,10 +141,10 @@ SlotID StackWithBonuses::unitSlot() const
 }
 
 const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector & selector, const CSelector & limit,
-	const CBonusSystemNode * root, const std::string & cachingStr) const
+	const CBonusSystemNode * root, const BonusCacheKey & cachingKey) const
 {
 	TBonusListPtr ret = std::make_shared<BonusList>();
-	const TBonusListPtr originalList = origBearer->getAllBonuses(selector, limit, root, cachingStr);
+	const TBonusListPtr originalList = origBearer->getAllBonuses(selector, limit, root, cachingKey);
 
 	vstd::copy_if(*originalList, std::back_inserter(*ret), [this](const std::shared_ptr<Bonus> & b)
 	{
@@ -137,12 +180,13 @@ const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector & selector,
 
 int64_t StackWithBonuses::getTreeVersion() const
 {
-	return owner->getTreeVersion();
+	return std::max(environment->getTreeVersion(), bonusesVersion);
 }
 
 void StackWithBonuses::addUnitBonus(const std::vector<Bonus> & bonus)
 {
 	vstd::concatenate(bonusesToAdd, bonus);
+	bonusesVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void StackWithBonuses::updateUnitBonus(const std::vector<Bonus> & bonus)
@@ -150,6 +194,7 @@ void StackWithBonuses::updateUnitBonus(const std::vector<Bonus> & bonus)
 	//TODO: optimize, actualize to last value
 
 	vstd::concatenate(bonusesToUpdate, bonus);
+	bonusesVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void StackWithBonuses::removeUnitBonus(const std::vector<Bonus> & bonus)
@@ -184,6 +229,7 @@ void StackWithBonuses::removeUnitBonus(const CSelector & selector)
 
 	vstd::erase_if(bonusesToAdd, [&](const Bonus & b){return selector(&b);});
 	vstd::erase_if(bonusesToUpdate, [&](const Bonus & b){return selector(&b);});
+	bonusesVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void StackWithBonuses::spendMana(const spells::PacketSender * server, const int spellCost) const
@@ -193,41 +239,92 @@ void StackWithBonuses::spendMana(const spells::PacketSender * server, const int
 
 HypotheticBattle::HypotheticBattle(Subject realBattle)
 	: BattleProxy(realBattle),
-	bonusTreeVersion(1)
+	environment(std::make_shared<HypotheticEnvironment>(realBattle)),
+	bonusTreeVersion(CBonusSystemNode::nextTreeVersion())
 {
 	auto activeUnit = realBattle->battleActiveUnit();
 	activeUnitId = activeUnit ? activeUnit->unitId() : -1;
 
-	nextId = 0xF0000000;
+	nextId = FIRST_ADDED_UNIT_ID;
 }
 
-bool HypotheticBattle::unitHasAmmoCart(const battle::Unit * unit) const
+HypotheticBattle::HypotheticBattle(const HypotheticBattle & other)
+	: CCallbackBase(),
+	BattleProxy(other.subject),
+	environment(other.environment),
+	unitStates(other.unitStates),
+	addedUnitStates(other.addedUnitStates),
+	bonusTreeVersion(other.bonusTreeVersion),
+	activeUnitId(other.activeUnitId),
+	nextId(other.nextId)
 {
-	//FIXME: check ammocart alive state here
-	return false;
 }
 
-PlayerColor HypotheticBattle::unitEffectiveOwner(const battle::Unit * unit) const
+HypotheticBattle HypotheticBattle::detachedCopy() const
 {
-	return battleGetOwner(unit);
+	HypotheticBattle copy(*this);
+
+	for(TUnitStates * states : {&copy.unitStates, &copy.addedUnitStates})
+	{
+		for(auto & state : *states)
+		{
+			if(state)
+				state = std::make_shared<StackWithBonuses>(*state);
+		}
+	}
+
+	return copy;
+}
+
+std::shared_ptr<const HypotheticEnvironment> HypotheticBattle::getEnvironment() const
+{
+	return environment;
+}
+
+std::shared_ptr<StackWithBonuses> & HypotheticBattle::unitSlot(uint32_t id)
+{
+	TUnitStates & states = id < FIRST_ADDED_UNIT_ID ? unitStates : addedUnitStates;
+	const size_t index = id < FIRST_ADDED_UNIT_ID ? id : id - FIRST_ADDED_UNIT_ID;
+
+	if(index >= states.size())
+		states.resize(index + 1);
+
+	return states[index];
+}
+
+const std::shared_ptr<StackWithBonuses> * HypotheticBattle::findUnitSlot(uint32_t id) const
+{
+	const TUnitStates & states = id < FIRST_ADDED_UNIT_ID ? unitStates : addedUnitStates;
+	const size_t index = id < FIRST_ADDED_UNIT_ID ? id : id - FIRST_ADDED_UNIT_ID;
+
+	if(index >= states.size() || !states[index])
+		return nullptr;
+
+	return &states[index];
+}
+
+const StackWithBonuses * HypotheticBattle::getUnitState(uint32_t id) const
+{
+	auto state = findUnitSlot(id);
+	return state ? state->get() : nullptr;
 }
 
 std::shared_ptr<StackWithBonuses> HypotheticBattle::getForUpdate(uint32_t id)
 {
-	auto iter = stackStates.find(id);
+	std::shared_ptr<StackWithBonuses> & state = unitSlot(id);
 
-	if(iter == stackStates.end())
+	if(!state)
 	{
 		const CStack * s = subject->battleGetStackByID(id, false);
-
-		auto ret = std::make_shared<StackWithBonuses>(this, s);
-		stackStates[id] = ret;
-		return ret;
+		state = std::make_shared<StackWithBonuses>(this, s);
 	}
-	else
+	else if(state.use_count() != 1)
 	{
-		return iter->second;
+		//state is shared with other copies of battle which should not see this change
+		state = std::make_shared<StackWithBonuses>(*state);
 	}
+
+	return state;
 }
 
 battle::Units HypotheticBattle::getUnitsIf(battle::UnitFilter predicate) const
@@ -240,14 +337,17 @@ battle::Units HypotheticBattle::getUnitsIf(battle::UnitFilter predicate) const
 	for(auto unit : proxyed)
 	{
 		//unit was not changed, trust proxyed data
-		if(stackStates.find(unit->unitId()) == stackStates.end())
+		if(!findUnitSlot(unit->unitId()))
 			ret.push_back(unit);
 	}
 
-	for(auto id_unit : stackStates)
+	for(const TUnitStates * states : {&unitStates, &addedUnitStates})
 	{
-		if(predicate(id_unit.second.get()))
-			ret.push_back(id_unit.second.get());
+		for(auto & state : *states)
+		{
+			if(state && predicate(state.get()))
+				ret.push_back(state.get());
+		}
 	}
 
 	return ret;
@@ -284,8 +384,7 @@ void HypotheticBattle::addUnit(uint32_t id, const JsonNode & data)
 {
 	battle::UnitInfo info;
 	info.load(id, data);
-	std::shared_ptr<StackWithBonuses> newUnit = std::make_shared<StackWithBonuses>(this, info);
-	stackStates[newUnit->unitId()] = newUnit;
+	unitSlot(id) = std::make_shared<StackWithBonuses>(this, info);
 }
 
 void HypotheticBattle::moveUnit(uint32_t id, BattleHex destination)
@@ -346,19 +445,19 @@ void HypotheticBattle::removeUnit(uint32_t id)
 void HypotheticBattle::addUnitBonus(uint32_t id, const std::vector<Bonus> & bonus)
 {
 	getForUpdate(id)->addUnitBonus(bonus);
-	bonusTreeVersion++;
+	bonusTreeVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void HypotheticBattle::updateUnitBonus(uint32_t id, const std::vector<Bonus> & bonus)
 {
 	getForUpdate(id)->updateUnitBonus(bonus);
-	bonusTreeVersion++;
+	bonusTreeVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void HypotheticBattle::removeUnitBonus(uint32_t id, const std::vector<Bonus> & bonus)
 {
 	getForUpdate(id)->removeUnitBonus(bonus);
-	bonusTreeVersion++;
+	bonusTreeVersion = CBonusSystemNode::nextTreeVersion();
 }
 
 void HypotheticBattle::setWallState(int partOfWall, si8 state)
@@ -388,5 +487,5 @@ int64_t HypotheticBattle::getActualDamage(const TDmgRange & damage, int32_t atta
 
 int64_t HypotheticBattle::getTreeVersion() const
 {
-	return getBattleNode()->getTreeVersion() + bonusTreeVersion;
+	return std::max(getBattleNode()->getTreeVersion(), bonusTreeVersion);
 }
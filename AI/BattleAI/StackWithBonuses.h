@@ -15,6 +15,22 @@
 class HypotheticBattle;
 class CStack;
 
+/// Part of hypothetic battle which is same for all its copies.
+/// Unit states refer to it instead of particular battle, so they can be shared between copies.
+class HypotheticEnvironment : public battle::IUnitEnvironment
+{
+public:
+	HypotheticEnvironment(std::shared_ptr<CBattleInfoCallback> realBattle_);
+
+	bool unitHasAmmoCart(const battle::Unit * unit) const override;
+	PlayerColor unitEffectiveOwner(const battle::Unit * unit) const override;
+
+	int64_t getTreeVersion() const;
+
+private:
+	std::shared_ptr<CBattleInfoCallback> realBattle;
+};
+
 class StackWithBonuses : public battle::CUnitState, public virtual IBonusBearer
 {
 public:
@@ -27,6 +43,9 @@ public:
 
 	StackWithBonuses(const HypotheticBattle * Owner, const battle::UnitInfo & info);
 
+	/// Copy for battle which is about to change state shared with other battles
+	StackWithBonuses(const StackWithBonuses & other);
+
 	virtual ~StackWithBonuses();
 
 	StackWithBonuses & operator= (const battle::CUnitState & other);
@@ -43,7 +62,7 @@ public:
 
 	///IBonusBearer
 	const TBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit,
-		const CBonusSystemNode * root = nullptr, const std::string & cachingStr = "") const override;
+		const CBonusSystemNode * root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override;
 
 	int64_t getTreeVersion() const override;
 
@@ -57,7 +76,8 @@ public:
 
 private:
 	const IBonusBearer * origBearer;
-	const HypotheticBattle * owner;
+	std::shared_ptr<const HypotheticEnvironment> environment;
+	int64_t bonusesVersion; //renewed from tree version counter on every change of own bonuses
 
 	const CCreature * type;
 	ui32 baseAmount;
@@ -67,16 +87,32 @@ private:
 	SlotID slot;
 };
 
-class HypotheticBattle : public BattleProxy, public battle::IUnitEnvironment
+class HypotheticBattle : public BattleProxy
 {
 public:
-	std::map<uint32_t, std::shared_ptr<StackWithBonuses>> stackStates;
+	enum : uint32_t
+	{
+		FIRST_ADDED_UNIT_ID = 0xF0000000 //units added in hypothetic battle get ids from here to not collide with real ones
+	};
 
 	HypotheticBattle(Subject realBattle);
 
-	bool unitHasAmmoCart(const battle::Unit * unit) const override;
-	PlayerColor unitEffectiveOwner(const battle::Unit * unit) const override;
+	/// Copying is cheap: unit states are shared between copies until one of them changes the unit.
+	/// So copy is a fork of battle state, and kept copy is a snapshot to fork again from.
+	/// Shared states fill their bonus caches lazily without locking, so copies must stay on the thread of the original.
+	HypotheticBattle(const HypotheticBattle & other);
+
+	/// Copy with its own clones of all unit states, can be used on a different thread than this battle.
+	/// Must be made while no other thread uses this battle.
+	HypotheticBattle detachedCopy() const;
 
+	std::shared_ptr<const HypotheticEnvironment> getEnvironment() const;
+
+	/// Changed state of unit or nullptr if unit is same as in real battle
+	const StackWithBonuses * getUnitState(uint32_t id) const;
+
+	/// Returned state is owned by this battle only and may replace state obtained before,
+	/// so units should be looked up again by id after calling it.
 	std::shared_ptr<StackWithBonuses> getForUpdate(uint32_t id);
 
 	int32_t getActiveStackID() const override;
@@ -107,7 +143,16 @@ public:
 	int64_t getTreeVersion() const;
 
 private:
-	int32_t bonusTreeVersion;
+	typedef std::vector<std::shared_ptr<StackWithBonuses>> TUnitStates;
+
+	std::shared_ptr<HypotheticEnvironment> environment;
+	TUnitStates unitStates; //[unit id], nullptr for unchanged units
+	TUnitStates addedUnitStates; //[unit id - FIRST_ADDED_UNIT_ID]
+
+	int64_t bonusTreeVersion; //renewed from tree version counter on every change of unit bonuses
 	int32_t activeUnitId;
 	mutable uint32_t nextId;
+
+	std::shared_ptr<StackWithBonuses> & unitSlot(uint32_t id);
+	const std::shared_ptr<StackWithBonuses> * findUnitSlot(uint32_t id) const;
 };
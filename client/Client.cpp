@@ -18,6 +18,7 @@
 #include "../lib/CConsoleHandler.h"
 #include "CGameInfo.h"
 #include "../lib/CGameState.h"
+#include "../lib/CPlayerState.h"
 #include "CPlayerInterface.h"
 #include "../lib/StartInfo.h"
 #include "../lib/battle/BattleInfo.h"
@@ -109,7 +110,6 @@ public:
 CClient::CClient()
 {
 	waitingRequest.clear();
-	pathInfo = nullptr;
 	applier = std::make_shared<CApplier<CBaseForCLApply>>();
 	registerTypesClientPacks1(*applier);
 	registerTypesClientPacks2(*applier);
@@ -316,7 +316,9 @@ void CClient::initMapHandler()
 		CGI->mh->init();
 		logNetwork->trace("Initializing mapHandler (together): %d ms", CSH->th->getDiff());
 	}
-	pathInfo = make_unique<CPathsInfo>(getMapSize());
+	pathsInfo.clear();
+	outdatedPaths.clear();
+	removedPaths.clear();
 }
 
 void CClient::initPlayerInterfaces()
@@ -619,20 +621,57 @@ void CClient::waitForMoveAndSend(PlayerColor color)
 
 void CClient::invalidatePaths()
 {
-	// turn pathfinding info into invalid. It will be regenerated later
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	pathInfo->hero = nullptr;
+	// mark pathfinding info as outdated. It will be updated or regenerated later
+	boost::unique_lock<boost::mutex> pathsLock(pathsMx);
+	for(auto & paths : pathsInfo)
+		outdatedPaths.insert(paths.first);
+}
+
+void CClient::removePaths(const CGHeroInstance * h)
+{
+	boost::unique_lock<boost::mutex> pathsLock(pathsMx);
+	auto iter = pathsInfo.find(h);
+	if(iter != pathsInfo.end())
+	{
+		removedPaths.push_back(iter->second);
+		pathsInfo.erase(iter);
+	}
+	outdatedPaths.erase(h);
 }
 
 const CPathsInfo * CClient::getPathsInfo(const CGHeroInstance * h)
 {
 	assert(h);
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	if(pathInfo->hero != h)
+	boost::unique_lock<boost::mutex> pathsLock(pathsMx);
+	auto iter = pathsInfo.find(h);
+	if(iter != pathsInfo.end() && !vstd::contains(outdatedPaths, h))
+		return iter->second.get();
+
+	// AI usually asks for paths of all its heroes in a row so compute them at once
+	const PlayerState * owner = gs->getPlayer(h->tempOwner);
+	if(owner && !owner->human)
 	{
-		gs->calculatePaths(h, *pathInfo.get());
+		std::vector<boost::unique_lock<boost::mutex>> pathLocks;
+		for(auto & paths : pathsInfo)
+			pathLocks.emplace_back(paths.second->pathMx);
+
+		gs->calculatePaths(h->tempOwner, pathsInfo);
+		for(const CGHeroInstance * hero : owner->heroes)
+			outdatedPaths.erase(hero);
+
+		iter = pathsInfo.find(h);
+		if(iter != pathsInfo.end() && !vstd::contains(outdatedPaths, h))
+			return iter->second.get();
 	}
-	return pathInfo.get();
+
+	auto & paths = pathsInfo[h];
+	if(!paths)
+		paths = std::make_shared<CPathsInfo>(getMapSize());
+
+	boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+	gs->updatePaths(h, *paths);
+	outdatedPaths.erase(h);
+	return paths.get();
 }
 
 PlayerColor CClient::getLocalPlayer() const
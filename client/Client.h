@@ -99,7 +99,11 @@ public:
 class CClient : public IGameCallback
 {
 	std::shared_ptr<CApplier<CBaseForCLApply>> applier;
-	std::unique_ptr<CPathsInfo> pathInfo;
+	mutable boost::mutex pathsMx;
+	std::map<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> pathsInfo;
+	std::set<const CGHeroInstance *> outdatedPaths;
+	//paths of removed heroes, callers keep raw pointers to them across calls so they live until map is reset
+	std::vector<std::shared_ptr<CPathsInfo>> removedPaths;
 
 	std::map<PlayerColor, std::shared_ptr<boost::thread>> playerActionThreads;
 	void waitForMoveAndSend(PlayerColor color);
@@ -150,6 +154,7 @@ public:
 	void stopAllBattleActions();
 
 	void invalidatePaths();
+	void removePaths(const CGHeroInstance * h); //hero was removed from map or its owner has changed
 	const CPathsInfo * getPathsInfo(const CGHeroInstance * h);
 	virtual PlayerColor getLocalPlayer() const override;
 
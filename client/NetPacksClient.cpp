@@ -29,6 +29,7 @@
 #include "mapHandler.h"
 #include "windows/GUIClasses.h"
 #include "../lib/CConfigHandler.h"
+#include "../lib/CStopWatch.h"
 #include "gui/SDL_Extensions.h"
 #include "battle/CBattleInterface.h"
 #include "../lib/mapping/CCampaignHandler.h"
@@ -371,6 +372,9 @@ void RemoveObject::applyFirstCl(CClient *cl)
 		if(GS(cl)->isVisible(o, i->first))
 			i->second->objectRemoved(o);
 	}
+
+	if(auto hero = dynamic_cast<const CGHeroInstance *>(o))
+		cl->removePaths(hero);
 }
 
 void RemoveObject::applyCl(CClient *cl)
@@ -504,6 +508,7 @@ void HeroRecruited::applyCl(CClient *cl)
 	{
 		logNetwork->error("Something wrong with hero recruited!");
 	}
+	cl->removePaths(h);
 
 	bool needsPrinting = true;
 	if(callInterfaceIfPresent(cl, h->tempOwner, &IGameEventsReceiver::heroCreated, h))
@@ -521,6 +526,7 @@ void HeroRecruited::applyCl(CClient *cl)
 void GiveHero::applyCl(CClient *cl)
 {
 	CGHeroInstance *h = GS(cl)->getHero(id);
+	cl->removePaths(h);
 	if(CGI->mh)
 		CGI->mh->printObject(h);
 	callInterfaceIfPresent(cl, h->tempOwner, &IGameEventsReceiver::heroCreated, h);
@@ -775,9 +781,24 @@ void SaveGameClient::applyCl(CClient *cl)
 
 	try
 	{
-		CSaveFile save(*CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)));
-		cl->saveCommonState(save);
-		save << *cl;
+		const auto savePath = *CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME));
+		const bool compressed = settings["general"]["compressSaves"].Bool();
+		CStopWatch timer;
+
+		if(settings["general"]["backgroundSaving"].Bool())
+		{
+			CSaveBuffer save;
+			cl->saveCommonState(save);
+			save << *cl;
+			logNetwork->info("Client state serialized in %d ms, %d KB", timer.getDiff(), save.getSize() / 1024);
+			save.writeInBackground(savePath, compressed);
+		}
+		else
+		{
+			CSaveFile save(savePath, compressed);
+			cl->saveCommonState(save);
+			save << *cl;
+		}
 	}
 	catch(std::exception &e)
 	{
@@ -513,7 +513,7 @@ std::shared_ptr<boost::multi_array<TerrainTile*, 3>> CGameInfoCallback::getAllVi
 		for (size_t y = 0; y < height; y++)
 			for (size_t z = 0; z < levels; z++)
 			{
-				if (team->fogOfWarMap[x][y][z])
+				if (team->fogOfWarMap.isVisible(int3(x, y, z)))
 					tileArray[x][y][z] = &gs->map->getTile(int3(x, y, z));
 				else
 					tileArray[x][y][z] = nullptr;
@@ -689,7 +689,7 @@ CGameInfoCallback::CGameInfoCallback(CGameState *GS, boost::optional<PlayerColor
 	player = Player;
 }
 
-const std::vector< std::vector< std::vector<ui8> > > & CPlayerSpecificInfoCallback::getVisibilityMap() const
+const FogOfWarMap & CPlayerSpecificInfoCallback::getVisibilityMap() const
 {
 	//boost::shared_lock<boost::shared_mutex> lock(*gs->mx);
 	return gs->getPlayerTeam(*player)->fogOfWarMap;
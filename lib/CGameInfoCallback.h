@@ -10,6 +10,7 @@
 #pragma once
 
 #include "int3.h"
+#include "FogOfWarMap.h"
 #include "ResourceSet.h" // for Res::ERes
 #include "battle/CPlayerBattleCallback.h"
 
@@ -144,7 +145,7 @@ public:
 
 	int getResourceAmount(Res::ERes type) const;
 	TResources getResourceAmount() const;
-	const std::vector< std::vector< std::vector<ui8> > > & getVisibilityMap()const; //returns visibility map
+	const FogOfWarMap & getVisibilityMap()const; //returns visibility map
 	const PlayerSettings * getPlayerSettings(PlayerColor color) const;
 };
 
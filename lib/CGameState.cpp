@@ -32,6 +32,7 @@
 #include "GameConstants.h"
 #include "rmg/CMapGenerator.h"
 #include "CStopWatch.h"
+#include "CThreadHelper.h"
 #include "mapping/CMapEditManager.h"
 #include "serializer/CTypeList.h"
 #include "serializer/CMemorySerializer.h"
@@ -1178,6 +1179,8 @@ void CGameState::prepareCrossoverHeroes(std::vector<CGameState::CampaignHeroRepl
 
 				cgh->getBonusLocalFirst(sel)->val = cgh->type->heroClass->primarySkillInitial[g];
 			}
+			//values were changed in place, cached bonuses must be dropped
+			cgh->nodeHasChanged();
 		}
 	}
 
@@ -1519,29 +1522,13 @@ void CGameState::initFogOfWar()
 	logGlobal->debug("\tFog of war"); //FIXME: should be initialized after all bonuses are set
 	for(auto & elem : teams)
 	{
-		elem.second.fogOfWarMap.resize(map->width);
-		for(int g=0; g<map->width; ++g)
-			elem.second.fogOfWarMap[g].resize(map->height);
-
-		for(int g=-0; g<map->width; ++g)
-			for(int h=0; h<map->height; ++h)
-				elem.second.fogOfWarMap[g][h].resize(map->twoLevel ? 2 : 1, 0);
-
-		for(int g=0; g<map->width; ++g)
-			for(int h=0; h<map->height; ++h)
-				for(int v = 0; v < (map->twoLevel ? 2 : 1); ++v)
-					elem.second.fogOfWarMap[g][h][v] = 0;
+		elem.second.fogOfWarMap.resize(int3(map->width, map->height, map->twoLevel ? 2 : 1));
 
 		for(CGObjectInstance *obj : map->objects)
 		{
 			if(!obj || !vstd::contains(elem.second.players, obj->tempOwner)) continue; //not a flagged object
 
-			std::unordered_set<int3, ShashInt3> tiles;
-			getTilesInRange(tiles, obj->getSightCenter(), obj->getSightRadius(), obj->tempOwner, 1);
-			for(int3 tile : tiles)
-			{
-				elem.second.fogOfWarMap[tile.x][tile.y][tile.z] = 1;
-			}
+			elem.second.fogOfWarMap.revealCircle(obj->getSightCenter(), obj->getSightRadius());
 		}
 	}
 }
@@ -1974,6 +1961,41 @@ void CGameState::calculatePaths(const CGHeroInstance *hero, CPathsInfo &out)
 	pathfinder.calculatePaths();
 }
 
+void CGameState::updatePaths(const CGHeroInstance *hero, CPathsInfo &out)
+{
+	CPathfinder pathfinder(out, this, hero);
+	pathfinder.updatePaths();
+}
+
+void CGameState::calculatePaths(PlayerColor player, std::map<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> & out)
+{
+	const PlayerState * p = getPlayer(player);
+	if(!p || p->heroes.empty())
+		return;
+
+	//accessibility and teleport channels are same for all heroes of player so they are computed only once
+	const std::vector<const CGHeroInstance *> heroes(p->heroes.begin(), p->heroes.end());
+	auto shared = std::make_shared<const CPathfinderSharedData>(this, player, heroes);
+
+	//pathfinders are created here so errors are reported in calling thread
+	std::vector<std::unique_ptr<CPathfinder>> pathfinders;
+	for(const CGHeroInstance * hero : heroes)
+	{
+		auto & paths = out[hero];
+		if(!paths)
+			paths = std::make_shared<CPathsInfo>(int3(map->width, map->height, map->twoLevel ? 2 : 1));
+
+		pathfinders.push_back(make_unique<CPathfinder>(*paths, this, hero, shared));
+	}
+
+	std::vector<Task> tasks;
+	for(auto & pathfinder : pathfinders)
+		tasks.push_back(std::bind(&CPathfinder::updatePaths, pathfinder.get()));
+
+	CThreadHelper threadHelper(&tasks);
+	threadHelper.run();
+}
+
 /**
  * Tells if the tile is guarded by a monster as well as the position
  * of the monster that will attack on it.
@@ -2031,7 +2053,7 @@ std::vector<CGObjectInstance*> CGameState::guardingCreatures (int3 pos) const
 
 int3 CGameState::guardingCreaturePosition (int3 pos) const
 {
-	return gs->map->guardingCreaturePositions[pos.x][pos.y][pos.z];
+	return gs->map->getGuardingCreaturePosition(pos);
 }
 
 void CGameState::updateRumor()
@@ -2115,7 +2137,7 @@ bool CGameState::isVisible(int3 pos, PlayerColor player)
 	if(player.isSpectator())
 		return true;
 
-	return getPlayerTeam(player)->fogOfWarMap[pos.x][pos.y][pos.z];
+	return getPlayerTeam(player)->fogOfWarMap.isVisible(pos);
 }
 
 bool CGameState::isVisible( const CGObjectInstance *obj, boost::optional<PlayerColor> player )
@@ -3083,6 +3105,19 @@ TeamState::TeamState(TeamState && other):
 	std::swap(fogOfWarMap, other.fogOfWarMap);
 }
 
+void TeamState::convertDeprecatedFogOfWar(const std::vector<std::vector<std::vector<ui8>>> & deprecated)
+{
+	const int width = deprecated.size();
+	const int height = width ? deprecated.front().size() : 0;
+	const int levels = height ? deprecated.front().front().size() : 0;
+
+	fogOfWarMap.resize(int3(width, height, levels));
+	for(int x = 0; x < width; x++)
+		for(int y = 0; y < height; y++)
+			for(int z = 0; z < levels; z++)
+				fogOfWarMap.setVisible(int3(x, y, z), deprecated[x][y][z]);
+}
+
 CRandomGenerator & CGameState::getRandomGenerator()
 {
 	return rand;
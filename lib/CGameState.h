@@ -178,6 +178,8 @@ public:
 	PlayerRelations::PlayerRelations getPlayerRelations(PlayerColor color1, PlayerColor color2);
 	bool checkForVisitableDir(const int3 & src, const int3 & dst) const; //check if src tile is visitable from dst tile
 	void calculatePaths(const CGHeroInstance *hero, CPathsInfo &out); //calculates possible paths for hero, by default uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+	void updatePaths(const CGHeroInstance *hero, CPathsInfo &out); //updates paths calculated earlier for same hero, only parts affected by changed tiles are recalculated when possible
+	void calculatePaths(PlayerColor player, std::map<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> & out); //calculates paths for all heroes of player at once, heroes are processed in parallel; existing entries of out are updated
 	int3 guardingCreaturePosition (int3 pos) const;
 	std::vector<CGObjectInstance*> guardingCreatures (int3 pos) const;
 	void updateRumor();
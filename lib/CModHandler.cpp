@@ -21,6 +21,10 @@
 #include "mapObjects/CObjectHandler.h"
 #include "StringConstants.h"
 #include "CStopWatch.h"
+#include "CThreadPool.h"
+#include "VCMIDirs.h"
+#include "serializer/BinaryDeserializer.h"
+#include "serializer/BinarySerializer.h"
 #include "IHandlerBase.h"
 #include "spells/CSpellHandler.h"
 #include "CSkillHandler.h"
@@ -327,12 +331,8 @@ ContentTypeHandler::ContentTypeHandler(IHandlerBase * handler, std::string objec
 	}
 }
 
-bool ContentTypeHandler::preloadModData(std::string modName, std::vector<std::string> fileList, bool validate)
+void ContentTypeHandler::preloadModData(std::string modName, JsonNode data)
 {
-	bool result;
-	JsonNode data = JsonUtils::assembleFromFiles(fileList, result);
-	data.setMeta(modName);
-
 	ModInfo & modInfo = modData[modName];
 
 	for(auto entry : data.Struct())
@@ -359,7 +359,6 @@ bool ContentTypeHandler::preloadModData(std::string modName, std::vector<std::st
 			JsonUtils::merge(remoteConf, entry.second);
 		}
 	}
-	return result;
 }
 
 bool ContentTypeHandler::loadMod(std::string modName, bool validate)
@@ -442,14 +441,12 @@ void CContentHandler::init()
 	//TODO: any other types of moddables?
 }
 
-bool CContentHandler::preloadModData(std::string modName, JsonNode modConfig, bool validate)
+void CContentHandler::preloadModData(std::string modName, std::map<std::string, JsonNode> modData)
 {
-	bool result = true;
 	for(auto & handler : handlers)
 	{
-		result &= handler.second.preloadModData(modName, modConfig[handler.first].convertTo<std::vector<std::string> >(), validate);
+		handler.second.preloadModData(modName, std::move(modData[handler.first]));
 	}
-	return result;
 }
 
 bool CContentHandler::loadMod(std::string modName, bool validate)
@@ -478,20 +475,35 @@ void CContentHandler::afterLoadFinalization()
 	}
 }
 
-void CContentHandler::preloadData(CModInfo & mod)
+std::map<std::string, JsonNode> CContentHandler::readModData(CModInfo & mod) const
 {
 	bool validate = (mod.validation != CModInfo::PASSED);
 
-	// print message in format [<8-symbols checksum>] <modname>
-	logMod->info("\t\t[%08x]%s", mod.checksum, mod.name);
-
 	if (validate && mod.identifier != "core")
 	{
 		if (!JsonUtils::validate(mod.config, "vcmi:mod", mod.identifier))
 			mod.validation = CModInfo::FAILED;
 	}
-	if (!preloadModData(mod.identifier, mod.config, validate))
-		mod.validation = CModInfo::FAILED;
+
+	std::map<std::string, JsonNode> modData;
+	for(auto & handler : handlers)
+	{
+		bool result;
+		JsonNode & data = modData[handler.first];
+		data = JsonUtils::assembleFromFiles(mod.config[handler.first].convertTo<std::vector<std::string> >(), result);
+		data.setMeta(mod.identifier);
+		if (!result)
+			mod.validation = CModInfo::FAILED;
+	}
+	return modData;
+}
+
+void CContentHandler::preloadData(CModInfo & mod, std::map<std::string, JsonNode> modData)
+{
+	// print message in format [<8-symbols checksum>] <modname>
+	logMod->info("\t\t[%08x]%s", mod.checksum, mod.name);
+
+	preloadModData(mod.identifier, std::move(modData));
 }
 
 void CContentHandler::load(CModInfo & mod)
@@ -958,6 +970,66 @@ void CModHandler::initializeConfig()
 	loadConfigFromFile("defaultMods.json");
 }
 
+static const std::string MOD_DATA_CACHE_MAGIC = "VCMI mod data cache";
+
+static boost::filesystem::path getModDataCachePath()
+{
+	return VCMIDirs::get().userCachePath() / "modDataCache.bin";
+}
+
+bool CModHandler::loadModDataCache(const TModDataCacheKey & key, TModDataList & modData) const
+{
+	const auto path = getModDataCachePath();
+	if(!boost::filesystem::exists(path))
+		return false;
+
+	try
+	{
+		CLoadFile cache(path);
+		cache.checkMagicBytes(MOD_DATA_CACHE_MAGIC);
+
+		TModDataCacheKey cachedKey;
+		cache >> cachedKey;
+		if(cachedKey != key)
+		{
+			logMod->debug("Mod data cache is outdated");
+			return false;
+		}
+		cache >> modData;
+		return modData.size() == key.size();
+	}
+	catch(std::exception & e)
+	{
+		logMod->warn("Failed to read mod data cache: %s", e.what());
+		modData.clear();
+		return false;
+	}
+}
+
+void CModHandler::saveModDataCache(const TModDataCacheKey & key, const TModDataList & modData) const
+{
+	// client and server may load mods at the same time, so cache is replaced only by complete file
+	const auto path = getModDataCachePath();
+	const auto tempPath = boost::filesystem::unique_path(path.string() + ".%%%%%%%%");
+
+	try
+	{
+		{
+			CSaveFile cache(tempPath);
+			cache.putMagicBytes(MOD_DATA_CACHE_MAGIC);
+			cache << key;
+			cache << modData;
+		}
+		boost::filesystem::rename(tempPath, path);
+	}
+	catch(std::exception & e)
+	{
+		logMod->warn("Failed to write mod data cache: %s", e.what());
+		boost::system::error_code ec;
+		boost::filesystem::remove(tempPath, ec);
+	}
+}
+
 void CModHandler::load()
 {
 	CStopWatch totalTime, timer;
@@ -966,18 +1038,69 @@ void CModHandler::load()
 
 	content.init();
 
-	for(const TModID & modName : activeMods)
+	// mods are independent until their data is merged, so files are hashed and parsed in parallel
+	// results are collected per mod and applied in load order to keep outcome deterministic
+	std::vector<ui32> checksums(activeMods.size());
+	std::vector<Task> tasks;
+	for(size_t i = 0; i < activeMods.size(); i++)
 	{
-		logMod->trace("Generating checksum for %s", modName);
-		allMods[modName].updateChecksum(calculateModChecksum(modName, CResourceHandler::get(modName)));
+		const TModID & modName = activeMods[i];
+		ISimpleResourceLoader * filesystem = CResourceHandler::get(modName);
+		tasks.push_back([&checksums, i, modName, filesystem]()
+		{
+			logMod->trace("Generating checksum for %s", modName);
+			checksums[i] = calculateModChecksum(modName, filesystem);
+		});
 	}
+	CThreadPool::get().run(tasks);
+
+	for(size_t i = 0; i < activeMods.size(); i++)
+		allMods[activeMods[i]].updateChecksum(checksums[i]);
+	logMod->info("\tCalculating checksums: %d ms", timer.getDiff());
 
 	// first - load virtual "core" mod that contains all data
 	// TODO? move all data into real mods? RoE, AB, SoD, WoG
-	content.preloadData(coreMod);
+	std::vector<CModInfo *> mods;
+	mods.push_back(&coreMod);
 	for(const TModID & modName : activeMods)
-		content.preloadData(allMods[modName]);
-	logMod->info("\tParsing mod data: %d ms", timer.getDiff());
+		mods.push_back(&allMods[modName]);
+
+	// cache holds data of mods that were validated already, their checksums guarantee that files are same
+	TModDataCacheKey cacheKey;
+	bool cacheAllowed = true;
+	for(const CModInfo * mod : mods)
+	{
+		cacheKey.push_back(std::make_pair(mod->identifier, mod->checksum));
+		if(mod->validation == CModInfo::PENDING)
+			cacheAllowed = false;
+	}
+
+	TModDataList modData;
+	if(cacheAllowed && loadModDataCache(cacheKey, modData))
+	{
+		logMod->info("\tReading cached mod data: %d ms", timer.getDiff());
+	}
+	else
+	{
+		modData.assign(mods.size(), std::map<std::string, JsonNode>());
+		tasks.clear();
+		for(size_t i = 0; i < mods.size(); i++)
+		{
+			tasks.push_back([this, &mods, &modData, i]()
+			{
+				modData[i] = content.readModData(*mods[i]);
+			});
+		}
+		CThreadPool::get().run(tasks);
+		logMod->info("\tParsing mod data: %d ms", timer.getDiff());
+
+		saveModDataCache(cacheKey, modData);
+		logMod->info("\tWriting mod data cache: %d ms", timer.getDiff());
+	}
+
+	for(size_t i = 0; i < mods.size(); i++)
+		content.preloadData(*mods[i], std::move(modData[i]));
+	logMod->info("\tMerging mod data: %d ms", timer.getDiff());
 
 	content.load(coreMod);
 	for(const TModID & modName : activeMods)
@@ -131,7 +131,7 @@ public:
 
 	/// local version of methods in ContentHandler
 	/// returns true if loading was successful
-	bool preloadModData(std::string modName, std::vector<std::string> fileList, bool validate);
+	void preloadModData(std::string modName, JsonNode data);
 	bool loadMod(std::string modName, bool validate);
 	void loadCustom();
 	void afterLoadFinalization();
@@ -140,8 +140,8 @@ public:
 /// class used to load all game data into handlers. Used only during loading
 class DLL_LINKAGE CContentHandler
 {
-	/// preloads all data from fileList as data from modName.
-	bool preloadModData(std::string modName, JsonNode modConfig, bool validate);
+	/// preloads already parsed data of modName, by handler name
+	void preloadModData(std::string modName, std::map<std::string, JsonNode> modData);
 
 	/// actually loads data in mod
 	bool loadMod(std::string modName, bool validate);
@@ -152,8 +152,11 @@ public:
 
 	void init();
 
-	/// preloads all data from fileList as data from modName.
-	void preloadData(CModInfo & mod);
+	/// reads and parses all data files of mod, by handler name. Does not touch handlers so mods can be read in parallel
+	std::map<std::string, JsonNode> readModData(CModInfo & mod) const;
+
+	/// preloads data of mod read by readModData. Mods must be preloaded in load order
+	void preloadData(CModInfo & mod, std::map<std::string, JsonNode> modData);
 
 	/// actually loads data in mod
 	void load(CModInfo & mod);
@@ -249,6 +252,15 @@ class DLL_LINKAGE CModHandler
 	std::vector<std::string> getModList(std::string path);
 	void loadMods(std::string path, std::string parent, const JsonNode & modSettings, bool enableMods);
 	void loadOneMod(std::string modName, std::string parent, const JsonNode & modSettings, bool enableMods);
+
+	/// identifiers and checksums of all loaded mods, core included, in load order
+	typedef std::vector<std::pair<TModID, ui32>> TModDataCacheKey;
+	/// data of each mod read by CContentHandler::readModData, in load order
+	typedef std::vector<std::map<std::string, JsonNode>> TModDataList;
+
+	/// reads mod data parsed on previous launch, returns false if cache is missing or made for other mods
+	bool loadModDataCache(const TModDataCacheKey & key, TModDataList & modData) const;
+	void saveModDataCache(const TModDataCacheKey & key, const TModDataList & modData) const;
 public:
 
 	CIdentifierStorage identifiers;
@@ -34,22 +34,257 @@ CPathfinder::PathfinderOptions::PathfinderOptions()
 	lightweightFlyingMode = settings["pathfinder"]["lightweightFlyingMode"].Bool();
 	oneTurnSpecialLayersLimit = settings["pathfinder"]["oneTurnSpecialLayersLimit"].Bool();
 	originalMovementRules = settings["pathfinder"]["originalMovementRules"].Bool();
+	useBucketQueue = settings["pathfinder"]["bucketQueue"].Bool();
+}
+
+CPathfinderSharedData::CPathfinderSharedData(CGameState * _gs, const PlayerColor & _player, const std::vector<const CGHeroInstance *> & heroes)
+	: CGameInfoCallback(_gs, boost::optional<PlayerColor>()), player(_player), FoW(getPlayerTeam(player)->fogOfWarMap), sizes(getMapSize())
+{
+	initializeAccessibility(heroes);
+	initializeTeleportChannels();
+}
+
+CGPathNode::EAccessibility CPathfinderSharedData::getAccessibility(const int3 & pos, const ELayer layer) const
+{
+	assert(layerIndices[layer] >= 0);
+	return accessibility[pos.x][pos.y][pos.z][layerIndices[layer]];
+}
+
+ETeleportChannelType CPathfinderSharedData::getTeleportType(const TeleportChannelID & channel) const
+{
+	auto it = teleportChannels.find(channel);
+	if(it == teleportChannels.end())
+		return ETeleportChannelType::IMPASSABLE;
+
+	return it->second.type;
+}
+
+const std::vector<ObjectInstanceID> & CPathfinderSharedData::getTeleportExits(const TeleportChannelID & channel) const
+{
+	static const std::vector<ObjectInstanceID> noExits;
+
+	auto it = teleportChannels.find(channel);
+	if(it == teleportChannels.end())
+		return noExits;
+
+	return it->second.exits;
+}
+
+bool CPathfinderSharedData::canSeeObj(const CGObjectInstance * obj)
+{
+	/// Pathfinder should ignore placed events
+	return obj != nullptr && obj->ID != Obj::EVENT;
+}
+
+void CPathfinderSharedData::initializeAccessibility(const std::vector<const CGHeroInstance *> & heroes)
+{
+	/// Land and sail are used by every hero, water and air only by heroes with corresponding movement bonus.
+	/// Same as in CPathfinder::initializeGraph, layers not available on first turn aren't needed at all
+	auto anyHeroHas = [&](Bonus::BonusType type)
+	{
+		return vstd::contains_if(heroes, [type](const CGHeroInstance * h)
+		{
+			return h->hasBonusOfType(type);
+		});
+	};
+
+	std::vector<ELayer> layers = {ELayer::LAND, ELayer::SAIL};
+	if(anyHeroHas(Bonus::WATER_WALKING))
+		layers.push_back(ELayer::WATER);
+	if(anyHeroHas(Bonus::FLYING_MOVEMENT))
+		layers.push_back(ELayer::AIR);
+
+	layerIndices.fill(-1);
+	for(size_t i = 0; i < layers.size(); i++)
+		layerIndices[layers[i]] = static_cast<si8>(i);
+
+	accessibility.resize(boost::extents[sizes.x][sizes.y][sizes.z][layers.size()]);
+
+	int3 pos;
+	for(pos.x=0; pos.x < sizes.x; ++pos.x)
+	{
+		for(pos.y=0; pos.y < sizes.y; ++pos.y)
+		{
+			for(pos.z=0; pos.z < sizes.z; ++pos.z)
+			{
+				const TerrainTile * tinfo = &gs->map->getTile(pos);
+				for(size_t i = 0; i < layers.size(); i++)
+					accessibility[pos.x][pos.y][pos.z][i] = evaluateAccessibility(pos, tinfo, layers[i]);
+			}
+		}
+	}
+}
+
+void CPathfinderSharedData::initializeTeleportChannels()
+{
+	/// Channel type and exits depend only on objects visible to player
+	/// So there is no need to compute them again for every hero and every visited teleporter
+	for(auto & channel : gs->map->teleportChannels)
+	{
+		TeleportChannelInfo & info = teleportChannels[channel.first];
+		info.type = getTeleportChannelType(channel.first, player);
+		info.exits = getTeleportChannelExits(channel.first, player);
+	}
+}
+
+CGPathNode::EAccessibility CPathfinderSharedData::evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const
+{
+	if(tinfo->terType == ETerrainType::ROCK || !FoW.isVisible(pos))
+		return CGPathNode::BLOCKED;
+
+	switch(layer)
+	{
+	case ELayer::LAND:
+	case ELayer::SAIL:
+		if(tinfo->visitable)
+		{
+			if(tinfo->visitableObjects.front()->ID == Obj::SANCTUARY && tinfo->visitableObjects.back()->ID == Obj::HERO && tinfo->visitableObjects.back()->tempOwner != player) //non-owned hero stands on Sanctuary
+			{
+				return CGPathNode::BLOCKED;
+			}
+			else
+			{
+				for(const CGObjectInstance * obj : tinfo->visitableObjects)
+				{
+					if(obj->blockVisit)
+					{
+						return CGPathNode::BLOCKVIS;
+					}
+					else if(obj->passableFor(player))
+					{
+						return CGPathNode::ACCESSIBLE;
+					}
+					else if(canSeeObj(obj))
+					{
+						return CGPathNode::VISITABLE;
+					}
+				}
+			}
+		}
+		else if(tinfo->blocked)
+		{
+			return CGPathNode::BLOCKED;
+		}
+		else if(gs->guardingCreaturePosition(pos).valid())
+		{
+			// Monster close by; blocked visit for battle
+			return CGPathNode::BLOCKVIS;
+		}
+
+		break;
+
+	case ELayer::WATER:
+		if(tinfo->blocked || tinfo->terType != ETerrainType::WATER)
+			return CGPathNode::BLOCKED;
+
+		break;
+
+	case ELayer::AIR:
+		if(tinfo->blocked || tinfo->terType == ETerrainType::WATER)
+			return CGPathNode::FLYABLE;
+
+		break;
+	}
+
+	return CGPathNode::ACCESSIBLE;
+}
+
+CPathNodeBucketQueue::CPathNodeBucketQueue()
+	: count(0), turn(0), remains(std::numeric_limits<ui32>::max())
+{
+}
+
+bool CPathNodeBucketQueue::empty() const
+{
+	return count == 0;
+}
+
+size_t CPathNodeBucketQueue::size() const
+{
+	return count;
+}
+
+void CPathNodeBucketQueue::push(CGPathNode * node)
+{
+	if(node->turns >= buckets.size())
+		buckets.resize(node->turns + 1);
+
+	auto & turnBuckets = buckets[node->turns];
+	if(turnBuckets.empty() && !spareTurns.empty())
+	{
+		turnBuckets.swap(spareTurns.back());
+		spareTurns.pop_back();
+	}
+	if(node->moveRemains >= turnBuckets.size())
+		turnBuckets.resize(node->moveRemains + 1);
+
+	turnBuckets[node->moveRemains].push_back(node);
+	count++;
+
+	if(node->turns < turn || (node->turns == turn && node->moveRemains > remains))
+	{
+		turn = node->turns;
+		remains = node->moveRemains;
+	}
+}
+
+CGPathNode * CPathNodeBucketQueue::top()
+{
+	seek();
+	return buckets[turn][remains].back();
+}
+
+void CPathNodeBucketQueue::pop()
+{
+	seek();
+	buckets[turn][remains].pop_back();
+	count--;
+}
+
+void CPathNodeBucketQueue::seek()
+{
+	assert(count);
+	for(;; turn++, remains = std::numeric_limits<ui32>::max())
+	{
+		auto & turnBuckets = buckets[turn];
+		if(turnBuckets.empty())
+			continue;
+
+		if(remains >= turnBuckets.size())
+			remains = static_cast<ui32>(turnBuckets.size() - 1);
+
+		for(;; remains--)
+		{
+			if(!turnBuckets[remains].empty())
+				return;
+			if(!remains)
+				break;
+		}
+
+		//whole turn is drained, its buckets keep allocated memory for next turns
+		spareTurns.push_back(std::vector<TBucket>());
+		spareTurns.back().swap(turnBuckets);
+	}
 }
 
 CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero)
-	: CGameInfoCallback(_gs, boost::optional<PlayerColor>()), out(_out), hero(_hero), FoW(getPlayerTeam(hero->tempOwner)->fogOfWarMap), patrolTiles({})
+	: CPathfinder(_out, _gs, _hero, std::make_shared<CPathfinderSharedData>(_gs, _hero->tempOwner, std::vector<const CGHeroInstance *>{_hero}))
+{
+}
+
+CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero, std::shared_ptr<const CPathfinderSharedData> _shared)
+	: CGameInfoCallback(_gs, boost::optional<PlayerColor>()), out(_out), hero(_hero), shared(_shared), patrolTiles({})
 {
 	assert(hero);
 	assert(hero == getHero(hero->id));
+	assert(shared && shared->player == hero->tempOwner);
 
     cp = dp = nullptr;
     ct = dt = nullptr;
     ctObj = dtObj = nullptr;
     destAction = CGPathNode::UNKNOWN;
 
-	out.hero = hero;
-	out.hpos = hero->getPosition(false);
-	if(!isInTheMap(out.hpos)/* || !gs->map->isInTheMap(dest)*/) //check input
+	if(!isInTheMap(hero->getPosition(false))/* || !gs->map->isInTheMap(dest)*/) //check input
 	{
 		logGlobal->error("CGameState::calculatePaths: Hero outside the gs->map? How dare you...");
 		throw std::runtime_error("Wrong checksum");
@@ -58,12 +293,224 @@ CPathfinder::CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstan
 	hlp = make_unique<CPathfinderHelper>(hero, options);
 
 	initializePatrol();
-	initializeGraph();
 	neighbourTiles.reserve(8);
 	neighbours.reserve(16);
 }
 
 void CPathfinder::calculatePaths()
+{
+	//logGlobal->info("Calculating paths for hero %s (adress  %d) of player %d", hero->name, hero , hero->tempOwner);
+
+	out.hero = hero;
+	out.hpos = hero->getPosition(false);
+	out.heroTreeVersion = hero->getTreeVersion();
+	initializeGraph();
+
+	//initial tile - set cost on 0 and add to the queue
+	CGPathNode * initialNode = out.getNode(out.hpos, hero->boat ? ELayer::SAIL : ELayer::LAND);
+	initialNode->turns = 0;
+	initialNode->moveRemains = hero->movement;
+	if(isHeroPatrolLocked())
+		return;
+
+	pushNode(initialNode);
+	searchPaths();
+}
+
+void CPathfinder::updatePaths()
+{
+	if(!isUpdatePossible())
+	{
+		calculatePaths();
+		return;
+	}
+
+	enum ENodeState : ui8
+	{
+		UNKNOWN = 0,
+		VALID,
+		INVALID,
+		SOURCE
+	};
+
+	std::vector<ENodeState> states(out.getNodesCount(), UNKNOWN);
+	auto state = [&](const CGPathNode * node) -> ENodeState &
+	{
+		return states[out.getIndex(node)];
+	};
+
+	/// If hero moved along calculated paths, node he stands on becomes root of new tree.
+	/// Its subtree stays valid: every path from new position was also considered from old one through it
+	const bool moved = out.hpos != hero->getPosition(false);
+	out.hpos = hero->getPosition(false);
+	CGPathNode * initialNode = out.getNode(out.hpos, hero->boat ? ELayer::SAIL : ELayer::LAND);
+	initialNode->theNodeBefore = CGPathNode::NO_PARENT;
+	initialNode->action = CGPathNode::UNKNOWN;
+	state(initialNode) = VALID;
+
+	/// Nodes which accessibility changed since last calculation are roots of invalid subtrees
+	bool initialNodeChanged = moved;
+	std::vector<CGPathNode *> invalidNodes;
+	for(ui32 index = 0; index < out.getNodesCount(); ++index)
+	{
+		CGPathNode * node = out.getNode(index);
+		if(!node || node->accessible == CGPathNode::NOT_SET || node->accessible == shared->getAccessibility(node->coord, node->layer))
+			continue;
+
+		/// Accessibility of starting tile doesn't limit movement from it
+		if(node == initialNode)
+		{
+			node->accessible = shared->getAccessibility(node->coord, node->layer);
+			initialNodeChanged = true;
+			continue;
+		}
+
+		state(node) = INVALID;
+		invalidNodes.push_back(node);
+	}
+
+	out.incrementalUpdates++;
+	if(invalidNodes.empty() && !initialNodeChanged)
+		return;
+
+	/// Every node which path goes through changed node is invalid as well
+	std::vector<CGPathNode *> chain;
+	for(ui32 index = 0; index < out.getNodesCount(); ++index)
+	{
+		CGPathNode * node = out.getNode(index);
+		if(!node || node->accessible == CGPathNode::NOT_SET || state(node) != UNKNOWN)
+			continue;
+
+		chain.clear();
+		CGPathNode * current = node;
+		while(current && state(current) == UNKNOWN)
+		{
+			chain.push_back(current);
+			current = out.getParent(current);
+		}
+
+		/// Reachable chains that don't end in starting node begin at previous hero position
+		ENodeState result = VALID;
+		if(current)
+			result = state(current);
+		else if(moved && chain.back()->reachable())
+			result = INVALID;
+
+		for(CGPathNode * chainNode : chain)
+		{
+			state(chainNode) = result;
+			if(result == INVALID)
+				invalidNodes.push_back(chainNode);
+		}
+	}
+
+	/// Expanded valid nodes next to invalid ones are sources of updated paths
+	auto addSource = [&](CGPathNode * node)
+	{
+		if(node && state(node) == VALID && node->locked)
+		{
+			state(node) = SOURCE;
+			pushNode(node);
+		}
+	};
+
+	/// Teleport and castle gate exits aren't neighbours of their entrances
+	std::set<TeleportChannelID> changedChannels;
+	bool changedTownExit = false;
+
+	for(CGPathNode * node : invalidNodes)
+	{
+		auto obj = gs->map->getTile(node->coord).topVisitableObj();
+		if(auto teleport = dynamic_cast<const CGTeleport *>(obj))
+			changedChannels.insert(teleport->channel);
+		else if(options.useCastleGate && obj && obj->ID == Obj::TOWN)
+			changedTownExit = true;
+
+		addSource(out.getParent(node));
+
+		int3 pos;
+		for(pos.x = node->coord.x - 1; pos.x <= node->coord.x + 1; ++pos.x)
+		{
+			for(pos.y = node->coord.y - 1; pos.y <= node->coord.y + 1; ++pos.y)
+			{
+				pos.z = node->coord.z;
+				if(!isInTheMap(pos))
+					continue;
+
+				for(ELayer layer = ELayer::LAND; layer < ELayer::NUM_LAYERS; layer.advance(1))
+				{
+					if(out.hasLayer(layer))
+						addSource(out.getNode(pos, layer));
+				}
+			}
+		}
+	}
+
+	/// so entrances leading to changed exits are sources as well
+	if(!changedChannels.empty() || changedTownExit)
+	{
+		for(ui32 index = 0; index < out.getNodesCount(); ++index)
+		{
+			CGPathNode * node = out.getNode(index);
+			if(!node || state(node) != VALID || !node->locked)
+				continue;
+
+			auto obj = gs->map->getTile(node->coord).topVisitableObj();
+			auto teleport = dynamic_cast<const CGTeleport *>(obj);
+			if((teleport && vstd::contains(changedChannels, teleport->channel))
+				|| (changedTownExit && obj && obj->ID == Obj::TOWN))
+			{
+				addSource(node);
+			}
+		}
+	}
+
+	for(CGPathNode * node : invalidNodes)
+		node->update(node->coord, node->layer, shared->getAccessibility(node->coord, node->layer));
+
+	/// Movement from starting tile has fewer restrictions than from other tiles, e.g. guarded ones
+	if(initialNodeChanged)
+	{
+		state(initialNode) = SOURCE;
+		pushNode(initialNode);
+	}
+
+	/// Valid nodes are unlocked so shortcuts through changed tiles can improve them
+	std::vector<CGPathNode *> lockedNodes;
+	for(ui32 index = 0; index < out.getNodesCount(); ++index)
+	{
+		CGPathNode * node = out.getNode(index);
+		if(node && node->locked && (state(node) == VALID || state(node) == SOURCE))
+		{
+			node->locked = false;
+			lockedNodes.push_back(node);
+		}
+	}
+
+	searchPaths();
+
+	for(CGPathNode * node : lockedNodes)
+		node->locked = true;
+}
+
+bool CPathfinder::isUpdatePossible() const
+{
+	if(out.hero != hero || out.heroTreeVersion != hero->getTreeVersion())
+		return false;
+
+	if(patrolState != PATROL_NONE)
+		return false;
+
+	/// Transition into air depends on starting tile in this mode
+	if(options.lightweightFlyingMode && out.hpos != hero->getPosition(false))
+		return false;
+
+	/// Hero stays in place or moved along calculated path and spent exactly as much movement points as it predicted
+	const CGPathNode * initialNode = out.getNode(hero->getPosition(false), hero->boat ? ELayer::SAIL : ELayer::LAND);
+	return initialNode->turns == 0 && initialNode->moveRemains == hero->movement;
+}
+
+void CPathfinder::searchPaths()
 {
 	auto passOneTurnLimitCheck = [&]() -> bool
 	{
@@ -95,20 +542,11 @@ void CPathfinder::calculatePaths()
 		return false;
 	};
 
-	//logGlobal->info("Calculating paths for hero %s (adress  %d) of player %d", hero->name, hero , hero->tempOwner);
-
-	//initial tile - set cost on 0 and add to the queue
-	CGPathNode * initialNode = out.getNode(out.hpos, hero->boat ? ELayer::SAIL : ELayer::LAND);
-	initialNode->turns = 0;
-	initialNode->moveRemains = hero->movement;
-	if(isHeroPatrolLocked())
-		return;
-
-	pq.push(initialNode);
-	while(!pq.empty())
+	while(hasQueuedNodes())
 	{
-		cp = pq.top();
-		pq.pop();
+		cp = popNode();
+		if(cp->locked) //node was queued again with better cost and already expanded
+			continue;
 		cp->locked = true;
 
 		int movement = cp->moveRemains, turn = cp->turns;
@@ -178,14 +616,14 @@ void CPathfinder::calculatePaths()
 				if(isBetterWay(remains, turnAtNextTile) &&
 					((cp->turns == turnAtNextTile && remains) || passOneTurnLimitCheck()))
 				{
-					assert(dp != cp->theNodeBefore); //two tiles can't point to each other
+					assert(dp != out.getParent(cp)); //two tiles can't point to each other
 					dp->moveRemains = remains;
 					dp->turns = turnAtNextTile;
-					dp->theNodeBefore = cp;
+					dp->theNodeBefore = out.getIndex(cp);
 					dp->action = destAction;
 
 					if(isMovementAfterDestPossible())
-						pq.push(dp);
+						pushNode(dp);
 				}
 			}
 		} //neighbours loop
@@ -211,15 +649,44 @@ void CPathfinder::calculatePaths()
 
 				dp->moveRemains = movement;
 				dp->turns = turn;
-				dp->theNodeBefore = cp;
+				dp->theNodeBefore = out.getIndex(cp);
 				dp->action = getTeleportDestAction();
 				if(dp->action == CGPathNode::TELEPORT_NORMAL)
-					pq.push(dp);
+					pushNode(dp);
 			}
 		}
 	} //queue loop
 }
 
+void CPathfinder::pushNode(CGPathNode * node)
+{
+	if(options.useBucketQueue)
+		bucketQueue.push(node);
+	else
+		pq.push(node);
+}
+
+CGPathNode * CPathfinder::popNode()
+{
+	CGPathNode * node;
+	if(options.useBucketQueue)
+	{
+		node = bucketQueue.top();
+		bucketQueue.pop();
+	}
+	else
+	{
+		node = pq.top();
+		pq.pop();
+	}
+	return node;
+}
+
+bool CPathfinder::hasQueuedNodes() const
+{
+	return options.useBucketQueue ? !bucketQueue.empty() : !pq.empty();
+}
+
 void CPathfinder::addNeighbours()
 {
 	neighbours.clear();
@@ -248,7 +715,7 @@ void CPathfinder::addTeleportExits()
 	const CGTeleport * objTeleport = dynamic_cast<const CGTeleport *>(ctObj);
 	if(isAllowedTeleportEntrance(objTeleport))
 	{
-		for(auto objId : getTeleportChannelExits(objTeleport->channel, hero->tempOwner))
+		for(auto objId : shared->getTeleportExits(objTeleport->channel))
 		{
 			auto obj = getObj(objId);
 			if(dynamic_cast<const CGWhirlpool *>(obj))
@@ -674,19 +1141,29 @@ void CPathfinder::initializePatrol()
 
 void CPathfinder::initializeGraph()
 {
+	/// Layers not available on first turn won't be available later either so they aren't needed at all
+	hlp->updateTurnInfo(0);
+	for(ELayer layer = ELayer::LAND; layer < ELayer::NUM_LAYERS; layer.advance(1))
+	{
+		if(!hlp->isLayerAvailable(layer))
+			out.releaseLayer(layer);
+	}
+
 	auto updateNode = [&](int3 pos, ELayer layer, const TerrainTile * tinfo)
 	{
 		auto node = out.getNode(pos, layer);
-		auto accessibility = evaluateAccessibility(pos, tinfo, layer);
-		node->update(pos, layer, accessibility);
+		node->update(pos, layer, shared->getAccessibility(pos, layer));
 	};
 
+	const bool useFlying = hlp->isLayerAvailable(ELayer::AIR);
+	const bool useWaterWalking = hlp->isLayerAvailable(ELayer::WATER);
+
 	int3 pos;
-	for(pos.x=0; pos.x < out.sizes.x; ++pos.x)
+	for(pos.z=0; pos.z < out.sizes.z; ++pos.z)
 	{
 		for(pos.y=0; pos.y < out.sizes.y; ++pos.y)
 		{
-			for(pos.z=0; pos.z < out.sizes.z; ++pos.z)
+			for(pos.x=0; pos.x < out.sizes.x; ++pos.x)
 			{
 				const TerrainTile * tinfo = &gs->map->getTile(pos);
 				switch(tinfo->terType)
@@ -696,15 +1173,15 @@ void CPathfinder::initializeGraph()
 
 				case ETerrainType::WATER:
 					updateNode(pos, ELayer::SAIL, tinfo);
-					if(options.useFlying)
+					if(useFlying)
 						updateNode(pos, ELayer::AIR, tinfo);
-					if(options.useWaterWalking)
+					if(useWaterWalking)
 						updateNode(pos, ELayer::WATER, tinfo);
 					break;
 
 				default:
 					updateNode(pos, ELayer::LAND, tinfo);
-					if(options.useFlying)
+					if(useFlying)
 						updateNode(pos, ELayer::AIR, tinfo);
 					break;
 				}
@@ -713,78 +1190,10 @@ void CPathfinder::initializeGraph()
 	}
 }
 
-CGPathNode::EAccessibility CPathfinder::evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const
-{
-	if(tinfo->terType == ETerrainType::ROCK || !FoW[pos.x][pos.y][pos.z])
-		return CGPathNode::BLOCKED;
-
-	switch(layer)
-	{
-	case ELayer::LAND:
-	case ELayer::SAIL:
-		if(tinfo->visitable)
-		{
-			if(tinfo->visitableObjects.front()->ID == Obj::SANCTUARY && tinfo->visitableObjects.back()->ID == Obj::HERO && tinfo->visitableObjects.back()->tempOwner != hero->tempOwner) //non-owned hero stands on Sanctuary
-			{
-				return CGPathNode::BLOCKED;
-			}
-			else
-			{
-				for(const CGObjectInstance * obj : tinfo->visitableObjects)
-				{
-					if(obj->blockVisit)
-					{
-						return CGPathNode::BLOCKVIS;
-					}
-					else if(obj->passableFor(hero->tempOwner))
-					{
-						return CGPathNode::ACCESSIBLE;
-					}
-					else if(canSeeObj(obj))
-					{
-						return CGPathNode::VISITABLE;
-					}
-				}
-			}
-		}
-		else if(tinfo->blocked)
-		{
-			return CGPathNode::BLOCKED;
-		}
-		else if(gs->guardingCreaturePosition(pos).valid())
-		{
-			// Monster close by; blocked visit for battle
-			return CGPathNode::BLOCKVIS;
-		}
-
-		break;
-
-	case ELayer::WATER:
-		if(tinfo->blocked || tinfo->terType != ETerrainType::WATER)
-			return CGPathNode::BLOCKED;
-
-		break;
-
-	case ELayer::AIR:
-		if(tinfo->blocked || tinfo->terType == ETerrainType::WATER)
-			return CGPathNode::FLYABLE;
-
-		break;
-	}
-
-	return CGPathNode::ACCESSIBLE;
-}
-
 bool CPathfinder::isVisitableObj(const CGObjectInstance * obj, const ELayer layer) const
 {
 	/// Hero can't visit objects while walking on water or flying
-	return canSeeObj(obj) && (layer == ELayer::LAND || layer == ELayer::SAIL);
-}
-
-bool CPathfinder::canSeeObj(const CGObjectInstance * obj) const
-{
-	/// Pathfinder should ignore placed events
-	return obj != nullptr && obj->ID != Obj::EVENT;
+	return CPathfinderSharedData::canSeeObj(obj) && (layer == ELayer::LAND || layer == ELayer::SAIL);
 }
 
 bool CPathfinder::canMoveBetween(const int3 & a, const int3 & b) const
@@ -794,7 +1203,7 @@ bool CPathfinder::canMoveBetween(const int3 & a, const int3 & b) const
 
 bool CPathfinder::isAllowedTeleportEntrance(const CGTeleport * obj) const
 {
-	if(!obj || !isTeleportEntrancePassable(obj, hero->tempOwner))
+	if(!obj || !obj->isEntrance() || shared->getTeleportType(obj->channel) == ETeleportChannelType::IMPASSABLE)
 		return false;
 
 	auto whirlpool = dynamic_cast<const CGWhirlpool *>(obj);
@@ -811,14 +1220,14 @@ bool CPathfinder::isAllowedTeleportEntrance(const CGTeleport * obj) const
 
 bool CPathfinder::addTeleportTwoWay(const CGTeleport * obj) const
 {
-	return options.useTeleportTwoWay && isTeleportChannelBidirectional(obj->channel, hero->tempOwner);
+	return options.useTeleportTwoWay && shared->getTeleportType(obj->channel) == ETeleportChannelType::BIDIRECTIONAL;
 }
 
 bool CPathfinder::addTeleportOneWay(const CGTeleport * obj) const
 {
-	if(options.useTeleportOneWay && isTeleportChannelUnidirectional(obj->channel, hero->tempOwner))
+	if(options.useTeleportOneWay && shared->getTeleportType(obj->channel) == ETeleportChannelType::UNIDIRECTIONAL)
 	{
-		auto passableExits = CGTeleport::getPassableExits(gs, hero, getTeleportChannelExits(obj->channel, hero->tempOwner));
+		auto passableExits = CGTeleport::getPassableExits(gs, hero, shared->getTeleportExits(obj->channel));
 		if(passableExits.size() == 1)
 			return true;
 	}
@@ -827,9 +1236,9 @@ bool CPathfinder::addTeleportOneWay(const CGTeleport * obj) const
 
 bool CPathfinder::addTeleportOneWayRandom(const CGTeleport * obj) const
 {
-	if(options.useTeleportOneWayRandom && isTeleportChannelUnidirectional(obj->channel, hero->tempOwner))
+	if(options.useTeleportOneWayRandom && shared->getTeleportType(obj->channel) == ETeleportChannelType::UNIDIRECTIONAL)
 	{
-		auto passableExits = CGTeleport::getPassableExits(gs, hero, getTeleportChannelExits(obj->channel, hero->tempOwner));
+		auto passableExits = CGTeleport::getPassableExits(gs, hero, shared->getTeleportExits(obj->channel));
 		if(passableExits.size() > 1)
 			return true;
 	}
@@ -860,10 +1269,7 @@ TurnInfo::BonusCache::BonusCache(TBonusListPtr bl)
 TurnInfo::TurnInfo(const CGHeroInstance * Hero, const int turn)
 	: hero(Hero), maxMovePointsLand(-1), maxMovePointsWater(-1)
 {
-	std::stringstream cachingStr;
-	cachingStr << "days_" << turn;
-
-	bonuses = hero->getAllBonuses(Selector::days(turn), nullptr, nullptr, cachingStr.str());
+	bonuses = hero->getAllBonuses(Selector::days(turn), nullptr, nullptr, BonusCacheKey::days(turn));
 	bonusCache = make_unique<BonusCache>(bonuses);
 	nativeTerrain = hero->getNativeTerrain();
 }
@@ -1132,7 +1538,7 @@ void CGPathNode::reset()
 	accessible = NOT_SET;
 	moveRemains = 0;
 	turns = 255;
-	theNodeBefore = nullptr;
+	theNodeBefore = NO_PARENT;
 	action = UNKNOWN;
 }
 
@@ -1179,7 +1585,13 @@ CPathsInfo::CPathsInfo(const int3 & Sizes)
 	: sizes(Sizes)
 {
 	hero = nullptr;
-	nodes.resize(boost::extents[sizes.x][sizes.y][sizes.z][ELayer::NUM_LAYERS]);
+	heroTreeVersion = -1;
+	incrementalUpdates = 0;
+	tilesCount = sizes.x * sizes.y * sizes.z;
+
+	/// Land and sail layers are used by every hero
+	allocateLayer(ELayer::LAND);
+	allocateLayer(ELayer::SAIL);
 }
 
 CPathsInfo::~CPathsInfo()
@@ -1202,13 +1614,13 @@ bool CPathsInfo::getPath(CGPath & out, const int3 & dst) const
 
 	out.nodes.clear();
 	const CGPathNode * curnode = getNode(dst);
-	if(!curnode->theNodeBefore)
+	if(curnode->theNodeBefore == CGPathNode::NO_PARENT)
 		return false;
 
 	while(curnode)
 	{
 		const CGPathNode cpn = * curnode;
-		curnode = curnode->theNodeBefore;
+		curnode = getParent(curnode);
 		out.nodes.push_back(cpn);
 	}
 	return true;
@@ -1227,14 +1639,95 @@ int CPathsInfo::getDistance(const int3 & tile) const
 
 const CGPathNode * CPathsInfo::getNode(const int3 & coord) const
 {
-	auto landNode = &nodes[coord.x][coord.y][coord.z][ELayer::LAND];
+	const ui32 tile = getTileIndex(coord);
+	auto landNode = &layers[ELayer::LAND][tile];
 	if(landNode->reachable())
 		return landNode;
 	else
-		return &nodes[coord.x][coord.y][coord.z][ELayer::SAIL];
+		return &layers[ELayer::SAIL][tile];
 }
 
 CGPathNode * CPathsInfo::getNode(const int3 & coord, const ELayer layer)
 {
-	return &nodes[coord.x][coord.y][coord.z][layer];
+	if(layers[layer].empty())
+		allocateLayer(layer);
+
+	return &layers[layer][getTileIndex(coord)];
+}
+
+CGPathNode * CPathsInfo::getNode(const ui32 index)
+{
+	auto & layer = layers[index / tilesCount];
+	return layer.empty() ? nullptr : &layer[index % tilesCount];
+}
+
+const CGPathNode * CPathsInfo::getParent(const CGPathNode * node) const
+{
+	if(node->theNodeBefore == CGPathNode::NO_PARENT)
+		return nullptr;
+
+	return &layers[node->theNodeBefore / tilesCount][node->theNodeBefore % tilesCount];
+}
+
+CGPathNode * CPathsInfo::getParent(const CGPathNode * node)
+{
+	if(node->theNodeBefore == CGPathNode::NO_PARENT)
+		return nullptr;
+
+	return &layers[node->theNodeBefore / tilesCount][node->theNodeBefore % tilesCount];
+}
+
+ui32 CPathsInfo::getIndex(const CGPathNode * node) const
+{
+	assert(node->layer != ELayer::WRONG);
+	return node->layer * tilesCount + static_cast<ui32>(node - layers[node->layer].data());
+}
+
+ui32 CPathsInfo::getNodesCount() const
+{
+	return ELayer::NUM_LAYERS * tilesCount;
+}
+
+bool CPathsInfo::hasLayer(const ELayer layer) const
+{
+	return !layers[layer].empty();
+}
+
+void CPathsInfo::releaseLayer(const ELayer layer)
+{
+	std::vector<CGPathNode>().swap(layers[layer]);
+}
+
+size_t CPathsInfo::getMemoryUsage() const
+{
+	size_t result = sizeof(CPathsInfo);
+	for(auto & layer : layers)
+		result += layer.capacity() * sizeof(CGPathNode);
+	return result;
+}
+
+ui32 CPathsInfo::getTileIndex(const int3 & coord) const
+{
+	return (coord.z * sizes.y + coord.y) * sizes.x + coord.x;
+}
+
+void CPathsInfo::allocateLayer(const ELayer layer)
+{
+	auto & nodes = layers[layer];
+	nodes.resize(tilesCount);
+
+	/// Nodes always know where they are so their index can be computed any time
+	int3 pos;
+	for(pos.z = 0; pos.z < sizes.z; ++pos.z)
+	{
+		for(pos.y = 0; pos.y < sizes.y; ++pos.y)
+		{
+			for(pos.x = 0; pos.x < sizes.x; ++pos.x)
+			{
+				CGPathNode & node = nodes[getTileIndex(pos)];
+				node.coord = pos;
+				node.layer = layer;
+			}
+		}
+	}
 }
@@ -51,8 +51,13 @@ struct DLL_LINKAGE CGPathNode
 		BLOCKED //tile can't be entered nor visited
 	};
 
-	CGPathNode * theNodeBefore;
+	enum : ui32
+	{
+		NO_PARENT = std::numeric_limits<ui32>::max()
+	};
+
 	int3 coord; //coordinates
+	ui32 theNodeBefore; //index of previous node in CPathsInfo or NO_PARENT
 	ui32 moveRemains; //remaining tiles after hero reaches the tile
 	ui8 turns; //how many turns we have to wait before reachng the tile - 0 means current turn
 	ELayer layer;
@@ -83,8 +88,9 @@ struct DLL_LINKAGE CPathsInfo
 
 	const CGHeroInstance * hero;
 	int3 hpos;
+	int64_t heroTreeVersion; //bonus tree version of hero at the moment of calculation
+	ui32 incrementalUpdates; //how many times paths were updated without full recalculation
 	int3 sizes;
-	boost::multi_array<CGPathNode, 4> nodes; //[w][h][level][layer]
 
 	CPathsInfo(const int3 & Sizes);
 	~CPathsInfo();
@@ -94,6 +100,87 @@ struct DLL_LINKAGE CPathsInfo
 	const CGPathNode * getNode(const int3 & coord) const;
 
 	CGPathNode * getNode(const int3 & coord, const ELayer layer);
+	CGPathNode * getNode(const ui32 index); //nullptr if layer of node is not allocated
+	const CGPathNode * getParent(const CGPathNode * node) const;
+	CGPathNode * getParent(const CGPathNode * node);
+	ui32 getIndex(const CGPathNode * node) const;
+	ui32 getNodesCount() const; //nodes of all layers, including not allocated ones
+
+	bool hasLayer(const ELayer layer) const;
+	void releaseLayer(const ELayer layer);
+	size_t getMemoryUsage() const;
+
+private:
+	/// Each layer is contiguous [z][y][x] array, so nodes visited by search are close to each other.
+	/// Land and sail layers always exist, air and water are allocated only for heroes who can use them.
+	std::array<std::vector<CGPathNode>, ELayer::NUM_LAYERS> layers;
+	ui32 tilesCount;
+
+	ui32 getTileIndex(const int3 & coord) const;
+	void allocateLayer(const ELayer layer);
+};
+
+/// Pathfinding data which doesn't depend on particular hero and so is identical for all heroes of one player.
+/// It's snapshot of current game state: must be recreated once map, fog of war or objects are changed.
+class DLL_LINKAGE CPathfinderSharedData : private CGameInfoCallback
+{
+public:
+	typedef EPathfindingLayer ELayer;
+
+	/// Accessibility is computed only for layers which at least one of given heroes is able to use
+	CPathfinderSharedData(CGameState * _gs, const PlayerColor & _player, const std::vector<const CGHeroInstance *> & heroes);
+
+	const PlayerColor player;
+
+	CGPathNode::EAccessibility getAccessibility(const int3 & pos, const ELayer layer) const;
+	ETeleportChannelType getTeleportType(const TeleportChannelID & channel) const;
+	const std::vector<ObjectInstanceID> & getTeleportExits(const TeleportChannelID & channel) const;
+
+	static bool canSeeObj(const CGObjectInstance * obj);
+
+private:
+	struct TeleportChannelInfo
+	{
+		ETeleportChannelType type;
+		std::vector<ObjectInstanceID> exits;
+	};
+
+	const FogOfWarMap & FoW;
+	int3 sizes;
+	std::array<si8, ELayer::NUM_LAYERS> layerIndices; //index of layer in accessibility array, -1 if it's not computed
+	boost::multi_array<CGPathNode::EAccessibility, 4> accessibility; //[w][h][level][computed layer]
+	std::map<TeleportChannelID, TeleportChannelInfo> teleportChannels;
+
+	void initializeAccessibility(const std::vector<const CGHeroInstance *> & heroes);
+	void initializeTeleportChannels();
+
+	CGPathNode::EAccessibility evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const;
+};
+
+/// Priority queue of path nodes with same order as boost heap used by pathfinder: by turns, then by most movement points left.
+/// Nodes are kept in buckets per (turns, moveRemains) pair. Pathfinder almost never pushes node better than last popped one,
+/// so both push and pop are amortized O(1); if it happens anyway cursor is simply moved back.
+class DLL_LINKAGE CPathNodeBucketQueue
+{
+public:
+	CPathNodeBucketQueue();
+
+	bool empty() const;
+	size_t size() const;
+	void push(CGPathNode * node);
+	CGPathNode * top();
+	void pop();
+
+private:
+	typedef std::vector<CGPathNode *> TBucket;
+
+	std::vector<std::vector<TBucket>> buckets; //[turns][moveRemains], turns without queued nodes may be not allocated
+	std::vector<std::vector<TBucket>> spareTurns; //already drained turns, reused to avoid reallocation
+	size_t count;
+	ui32 turn; //there are no queued nodes before (turn, remains) position
+	ui32 remains;
+
+	void seek();
 };
 
 class CPathfinder : private CGameInfoCallback
@@ -102,7 +189,13 @@ public:
 	friend class CPathfinderHelper;
 
 	CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero);
+	/// Reuses data already calculated for other heroes of the same player
+	CPathfinder(CPathsInfo & _out, CGameState * _gs, const CGHeroInstance * _hero, std::shared_ptr<const CPathfinderSharedData> _shared);
 	void calculatePaths(); //calculates possible paths for hero, uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+	/// Updates paths previously calculated for same hero. Only nodes which path goes through tiles with changed accessibility are recalculated.
+	/// If hero moved along calculated path, paths that went through his new position are kept and only the rest is recalculated.
+	/// Falls back to calculatePaths when movement points or bonuses changed in other way.
+	void updatePaths();
 
 private:
 	typedef EPathfindingLayer ELayer;
@@ -155,12 +248,16 @@ private:
 		///   I find it's reasonable limitation, but it's will make some movements more expensive than in H3.
 		bool originalMovementRules;
 
+		/// Use bucket queue instead of binary heap for open set of nodes.
+		/// Both give same paths, heap is kept mostly for comparison and as fallback.
+		bool useBucketQueue;
+
 		PathfinderOptions();
 	} options;
 
 	CPathsInfo & out;
 	const CGHeroInstance * hero;
-	const std::vector<std::vector<std::vector<ui8> > > &FoW;
+	std::shared_ptr<const CPathfinderSharedData> shared;
 	std::unique_ptr<CPathfinderHelper> hlp;
 
 	enum EPatrolState {
@@ -183,6 +280,7 @@ private:
 		}
 	};
 	boost::heap::priority_queue<CGPathNode *, boost::heap::compare<NodeComparer> > pq;
+	CPathNodeBucketQueue bucketQueue;
 
 	std::vector<int3> neighbourTiles;
 	std::vector<int3> neighbours;
@@ -193,6 +291,10 @@ private:
 	const CGObjectInstance * ctObj, * dtObj;
 	CGPathNode::ENodeAction destAction;
 
+	void pushNode(CGPathNode * node);
+	CGPathNode * popNode();
+	bool hasQueuedNodes() const;
+
 	void addNeighbours();
 	void addTeleportExits();
 
@@ -216,9 +318,10 @@ private:
 	void initializePatrol();
 	void initializeGraph();
 
-	CGPathNode::EAccessibility evaluateAccessibility(const int3 & pos, const TerrainTile * tinfo, const ELayer layer) const;
+	bool isUpdatePossible() const;
+	void searchPaths();
+
 	bool isVisitableObj(const CGObjectInstance * obj, const ELayer layer) const;
-	bool canSeeObj(const CGObjectInstance * obj) const;
 	bool canMoveBetween(const int3 & a, const int3 & b) const; //checks only for visitable objects that may make moving between tiles impossible, not other conditions (like tiles itself accessibility)
 
 	bool isAllowedTeleportEntrance(const CGTeleport * obj) const;
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "HeroBonus.h"
+#include "FogOfWarMap.h"
 
 class CGHeroInstance;
 class CGTownInstance;
@@ -72,17 +73,27 @@ struct DLL_LINKAGE TeamState : public CBonusSystemNode
 public:
 	TeamID id; //position in gameState::teams
 	std::set<PlayerColor> players; // members of this team
-	//TODO: boost::array, bool if possible
-	std::vector<std::vector<std::vector<ui8> > >  fogOfWarMap; //true - visible, false - hidden
+	FogOfWarMap fogOfWarMap;
 
 	TeamState();
 	TeamState(TeamState && other);
 
+	void convertDeprecatedFogOfWar(const std::vector<std::vector<std::vector<ui8>>> & deprecated);
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & id;
 		h & players;
-		h & fogOfWarMap;
+		if(version >= 788)
+		{
+			h & fogOfWarMap;
+		}
+		else
+		{
+			std::vector<std::vector<std::vector<ui8>>> fogOfWarDeprecated; //[x][y][z], one byte per tile
+			h & fogOfWarDeprecated;
+			convertDeprecatedFogOfWar(fogOfWarDeprecated);
+		}
 		h & static_cast<CBonusSystemNode&>(*this);
 	}
 
@@ -9,6 +9,7 @@
  */
 #include "StdInc.h"
 #include "CThreadHelper.h"
+#include "CThreadPool.h"
 
 #ifdef VCMI_WINDOWS
 	#include <windows.h>
@@ -16,34 +17,20 @@
 	#include <sys/prctl.h>
 #endif
 
-CThreadHelper::CThreadHelper(std::vector<std::function<void()> > *Tasks, int Threads)
+CThreadHelper::CThreadHelper(std::vector<std::function<void()> > *Tasks)
 {
-	currentTask = 0; amount = Tasks->size();
 	tasks = Tasks;
-	threads = Threads;
 }
 void CThreadHelper::run()
 {
-	boost::thread_group grupa;
-	for(int i=0;i<threads;i++)
-		grupa.create_thread(std::bind(&CThreadHelper::processTasks,this));
-	grupa.join_all();
-
-	//thread group deletes threads, do not free manually
-}
-void CThreadHelper::processTasks()
-{
-	while(true)
+	if(tasks->size() > 1)
+	{
+		CThreadPool::get().run(*tasks);
+	}
+	else
 	{
-		int pom;
-		{
-			boost::unique_lock<boost::mutex> lock(rtinm);
-			if((pom = currentTask) >= amount)
-				break;
-			else
-				++currentTask;
-		}
-		(*tasks)[pom]();
+		for(auto & task : *tasks)
+			task();
 	}
 }
 
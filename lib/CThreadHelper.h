@@ -12,17 +12,14 @@
 
 typedef std::function<void()> Task;
 
-/// Can assign CPU work to other threads/cores
+/// Can assign CPU work to other threads/cores, tasks are executed by process-wide CThreadPool
+/// which decides how many threads take part
 class DLL_LINKAGE CThreadHelper
 {
-	boost::mutex rtinm;
-	int currentTask, amount, threads;
 	std::vector<Task> *tasks;
 
-
-	void processTasks();
 public:
-	CThreadHelper(std::vector<std::function<void()> > *Tasks, int Threads);
+	CThreadHelper(std::vector<std::function<void()> > *Tasks);
 	void run();
 };
 
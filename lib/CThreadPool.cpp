@@ -0,0 +1,185 @@
+/*
+ * CThreadPool.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CThreadPool.h"
+
+namespace
+{
+	struct WorkerInfo
+	{
+		const CThreadPool * pool;
+		size_t index;
+	};
+
+	boost::thread_specific_ptr<WorkerInfo> workerInfo;
+}
+
+CThreadPool::CThreadPool(size_t threadsCount)
+	: queuedJobs(0), stopping(false)
+{
+	for(size_t i = 0; i < threadsCount; i++)
+		workers.push_back(make_unique<Worker>());
+
+	for(size_t i = 0; i < threadsCount; i++)
+		threads.create_thread(std::bind(&CThreadPool::workerLoop, this, i));
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(sleepMx);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	threads.join_all();
+}
+
+CThreadPool & CThreadPool::get()
+{
+	static CThreadPool pool(std::max<ui32>(boost::thread::hardware_concurrency(), 1) - 1);
+	return pool;
+}
+
+size_t CThreadPool::getThreadsCount() const
+{
+	return workers.size();
+}
+
+void CThreadPool::run(std::vector<Task> & tasks)
+{
+	if(tasks.empty())
+		return;
+
+	if(workers.empty())
+	{
+		for(auto & task : tasks)
+			task();
+		return;
+	}
+
+	auto batch = std::make_shared<Batch>();
+	batch->remaining = tasks.size();
+
+	const size_t self = currentWorker();
+
+	//counted before queueing so counter never goes below zero
+	{
+		boost::unique_lock<boost::mutex> lock(sleepMx);
+		queuedJobs += tasks.size();
+	}
+
+	//worker keeps tasks in own queue so they stay on this core unless someone is idle, others spread them evenly
+	for(size_t i = 0; i < tasks.size(); i++)
+	{
+		Worker & worker = *workers[self < workers.size() ? self : i % workers.size()];
+		boost::unique_lock<boost::mutex> lock(worker.mx);
+		worker.jobs.push_back(Job{&tasks[i], batch});
+	}
+	wakeUp.notify_all();
+
+	//help instead of blocking
+	Job job;
+	while(batch->remaining && (popJob(self, job) || stealJob(self, job)))
+		execute(job);
+
+	{
+		boost::unique_lock<boost::mutex> lock(batch->mx);
+		while(batch->remaining)
+			batch->finished.wait(lock);
+	}
+
+	if(batch->error)
+		std::rethrow_exception(batch->error);
+}
+
+size_t CThreadPool::currentWorker() const
+{
+	const WorkerInfo * info = workerInfo.get();
+	if(info && info->pool == this)
+		return info->index;
+	return workers.size();
+}
+
+bool CThreadPool::popJob(size_t index, Job & job)
+{
+	if(index >= workers.size())
+		return false;
+
+	Worker & worker = *workers[index];
+	boost::unique_lock<boost::mutex> lock(worker.mx);
+	if(worker.jobs.empty())
+		return false;
+
+	job = std::move(worker.jobs.back());
+	worker.jobs.pop_back();
+	queuedJobs--;
+	return true;
+}
+
+bool CThreadPool::stealJob(size_t thief, Job & job)
+{
+	for(size_t i = 1; i <= workers.size(); i++)
+	{
+		Worker & victim = *workers[(thief + i) % workers.size()];
+		boost::unique_lock<boost::mutex> lock(victim.mx);
+		if(victim.jobs.empty())
+			continue;
+
+		job = std::move(victim.jobs.front());
+		victim.jobs.pop_front();
+		queuedJobs--;
+		return true;
+	}
+	return false;
+}
+
+void CThreadPool::execute(Job & job)
+{
+	try
+	{
+		(*job.task)();
+	}
+	catch(...)
+	{
+		boost::unique_lock<boost::mutex> lock(job.batch->mx);
+		if(!job.batch->error)
+			job.batch->error = std::current_exception();
+	}
+
+	if(--job.batch->remaining == 0)
+	{
+		boost::unique_lock<boost::mutex> lock(job.batch->mx);
+		job.batch->finished.notify_all();
+	}
+	job.batch.reset();
+}
+
+void CThreadPool::workerLoop(size_t index)
+{
+	setThreadName("CThreadPool::worker");
+	workerInfo.reset(new WorkerInfo{this, index});
+
+	Job job;
+	while(true)
+	{
+		if(popJob(index, job) || stealJob(index, job))
+		{
+			execute(job);
+			continue;
+		}
+
+		boost::unique_lock<boost::mutex> lock(sleepMx);
+		while(!stopping && !queuedJobs)
+			wakeUp.wait(lock);
+
+		if(stopping)
+			return;
+	}
+}
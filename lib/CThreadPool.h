@@ -0,0 +1,68 @@
+/*
+ * CThreadPool.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "CThreadHelper.h"
+
+/// Set of persistent worker threads with work stealing.
+/// Each worker has own queue of tasks, idle workers steal tasks from queues of other workers.
+class DLL_LINKAGE CThreadPool : public boost::noncopyable
+{
+public:
+	explicit CThreadPool(size_t threadsCount);
+	~CThreadPool();
+
+	/// Process-wide pool with one worker less than hardware threads, caller of run is the last one
+	static CThreadPool & get();
+
+	size_t getThreadsCount() const;
+
+	/// Executes all tasks and returns once all of them are finished.
+	/// Calling thread executes tasks as well so it's safe to call it from inside of a task.
+	/// First exception thrown by any task is rethrown here after remaining tasks finished.
+	void run(std::vector<Task> & tasks);
+
+private:
+	struct Batch
+	{
+		std::atomic<size_t> remaining;
+		std::exception_ptr error;
+		boost::mutex mx;
+		boost::condition_variable finished;
+	};
+
+	struct Job
+	{
+		Task * task;
+		std::shared_ptr<Batch> batch;
+	};
+
+	struct Worker
+	{
+		boost::mutex mx;
+		std::deque<Job> jobs; //owner takes jobs from back, thieves from front
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	boost::thread_group threads;
+
+	boost::mutex sleepMx;
+	boost::condition_variable wakeUp;
+	std::atomic<size_t> queuedJobs;
+	bool stopping;
+
+	/// Index of worker of this pool running in current thread, or workers.size() for other threads
+	size_t currentWorker() const;
+
+	bool popJob(size_t index, Job & job);
+	bool stealJob(size_t thief, Job & job);
+	void execute(Job & job);
+	void workerLoop(size_t index);
+};
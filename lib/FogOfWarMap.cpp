@@ -0,0 +1,248 @@
+/*
+ * FogOfWarMap.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "FogOfWarMap.h"
+
+namespace
+{
+	/// Fills half-widths of circle rows indexed by distance from center row.
+	/// int3::dist rounds distance down, so tile is in range if its squared distance is below (radius + 1)^2
+	void fillCircleSpans(int radius, int * spans)
+	{
+		const int limit = (radius + 1) * (radius + 1);
+		int dx = radius;
+		for(int dy = 0; dy <= radius; dy++)
+		{
+			while(dx * dx + dy * dy >= limit)
+				dx--;
+			spans[dy] = dx;
+		}
+	}
+
+	/// Spans of all radii used by objects and spells, computed once so lookups need neither lock nor search
+	class CircleSpanTable
+	{
+	public:
+		static const int MAX_RADIUS = 64;
+
+		CircleSpanTable()
+			: spans(offset(MAX_RADIUS + 1))
+		{
+			for(int radius = 0; radius <= MAX_RADIUS; radius++)
+				fillCircleSpans(radius, &spans[offset(radius)]);
+		}
+
+		const int * get(int radius) const
+		{
+			return &spans[offset(radius)];
+		}
+
+	private:
+		std::vector<int> spans; //radius r takes r + 1 entries
+
+		static size_t offset(int radius)
+		{
+			return static_cast<size_t>(radius) * (radius + 1) / 2;
+		}
+	};
+
+	/// Larger radii are computed into buffer
+	const int * circleSpans(int radius, std::vector<int> & buffer)
+	{
+		static const CircleSpanTable table;
+		if(radius <= CircleSpanTable::MAX_RADIUS)
+			return table.get(radius);
+
+		buffer.resize(radius + 1);
+		fillCircleSpans(radius, buffer.data());
+		return buffer.data();
+	}
+
+	int lowestBit(FogOfWarMap::TWord word)
+	{
+#ifdef __GNUC__
+		return __builtin_ctzll(word);
+#else
+		int bit = 0;
+		while(!(word & 1))
+		{
+			word >>= 1;
+			bit++;
+		}
+		return bit;
+#endif
+	}
+}
+
+FogOfWarMap::FogOfWarMap()
+	: wordsPerLevel(0)
+{
+
+}
+
+FogOfWarMap::FogOfWarMap(const int3 & sizes)
+{
+	resize(sizes);
+}
+
+void FogOfWarMap::resize(const int3 & newSizes)
+{
+	sizes = newSizes;
+	wordsPerLevel = wordsForLevel(sizes);
+	words.assign(wordsPerLevel * sizes.z, 0);
+}
+
+const int3 & FogOfWarMap::getSizes() const
+{
+	return sizes;
+}
+
+size_t FogOfWarMap::wordsForLevel(const int3 & sizes)
+{
+	return (static_cast<size_t>(sizes.x) * sizes.y + WORD_BITS - 1) / WORD_BITS;
+}
+
+void FogOfWarMap::setVisible(const int3 & tile, bool visible)
+{
+	const size_t bit = bitIndex(tile);
+	const TWord mask = TWord(1) << (bit % WORD_BITS);
+	if(visible)
+		words[bit / WORD_BITS] |= mask;
+	else
+		words[bit / WORD_BITS] &= ~mask;
+}
+
+void FogOfWarMap::setAll(bool visible)
+{
+	//bits past the end of level are set too, everything reading words masks them out
+	std::fill(words.begin(), words.end(), visible ? ~TWord(0) : TWord(0));
+}
+
+void FogOfWarMap::revealCircle(const int3 & center, int radius)
+{
+	if(radius < 0)
+	{
+		setAll(true);
+		return;
+	}
+
+	forEachCircleRow(center, radius, [this](size_t firstBit, size_t lastBit)
+	{
+		forEachWord(firstBit, lastBit, [this](size_t wordIndex, TWord mask)
+		{
+			words[wordIndex] |= mask;
+		});
+	});
+}
+
+FogOfWarMap & FogOfWarMap::operator|=(const FogOfWarMap & other)
+{
+	assert(sizes == other.sizes);
+	for(size_t i = 0; i < words.size(); i++)
+		words[i] |= other.words[i];
+	return *this;
+}
+
+FogOfWarMap & FogOfWarMap::operator&=(const FogOfWarMap & other)
+{
+	assert(sizes == other.sizes);
+	for(size_t i = 0; i < words.size(); i++)
+		words[i] &= other.words[i];
+	return *this;
+}
+
+FogOfWarMap & FogOfWarMap::subtract(const FogOfWarMap & other)
+{
+	assert(sizes == other.sizes);
+	for(size_t i = 0; i < words.size(); i++)
+		words[i] &= ~other.words[i];
+	return *this;
+}
+
+void FogOfWarMap::forEachTile(bool visible, const TTileFunction & function) const
+{
+	for(size_t i = 0; i < words.size(); i++)
+		forEachSetBit(i, visible ? words[i] : ~words[i], function);
+}
+
+void FogOfWarMap::forEachTileInCircle(const int3 & center, int radius, bool visible, const TTileFunction & function) const
+{
+	if(radius < 0)
+	{
+		forEachTile(visible, function);
+		return;
+	}
+
+	forEachCircleRow(center, radius, [&](size_t firstBit, size_t lastBit)
+	{
+		forEachWord(firstBit, lastBit, [&](size_t wordIndex, TWord mask)
+		{
+			forEachSetBit(wordIndex, (visible ? words[wordIndex] : ~words[wordIndex]) & mask, function);
+		});
+	});
+}
+
+template<typename Function>
+void FogOfWarMap::forEachCircleRow(const int3 & center, int radius, const Function & function) const
+{
+	if(center.z < 0 || center.z >= sizes.z)
+		return;
+
+	std::vector<int> buffer;
+	const int * spans = circleSpans(radius, buffer);
+	const size_t levelBit = center.z * wordsPerLevel * WORD_BITS;
+
+	const int firstRow = std::max(center.y - radius, 0);
+	const int lastRow = std::min(center.y + radius, sizes.y - 1);
+	for(int y = firstRow; y <= lastRow; y++)
+	{
+		const int span = spans[std::abs(y - center.y)];
+		const int firstColumn = std::max(center.x - span, 0);
+		const int lastColumn = std::min(center.x + span, sizes.x - 1);
+		if(firstColumn > lastColumn)
+			continue;
+
+		const size_t rowBit = levelBit + static_cast<size_t>(y) * sizes.x;
+		function(rowBit + firstColumn, rowBit + lastColumn);
+	}
+}
+
+template<typename Function>
+void FogOfWarMap::forEachWord(size_t firstBit, size_t lastBit, const Function & function)
+{
+	const size_t firstWord = firstBit / WORD_BITS;
+	const size_t lastWord = lastBit / WORD_BITS;
+	for(size_t i = firstWord; i <= lastWord; i++)
+	{
+		TWord mask = ~TWord(0);
+		if(i == firstWord)
+			mask &= ~TWord(0) << (firstBit % WORD_BITS);
+		if(i == lastWord)
+			mask &= ~TWord(0) >> (WORD_BITS - 1 - lastBit % WORD_BITS);
+		function(i, mask);
+	}
+}
+
+void FogOfWarMap::forEachSetBit(size_t wordIndex, TWord word, const TTileFunction & function) const
+{
+	const size_t levelTiles = static_cast<size_t>(sizes.x) * sizes.y;
+	const int z = static_cast<int>(wordIndex / wordsPerLevel);
+	const size_t firstTile = (wordIndex % wordsPerLevel) * WORD_BITS;
+
+	while(word)
+	{
+		const size_t tile = firstTile + lowestBit(word);
+		if(tile >= levelTiles)
+			break; //padding at the end of level
+		word &= word - 1;
+
+		function(int3(static_cast<int>(tile % sizes.x), static_cast<int>(tile / sizes.x), z));
+	}
+}
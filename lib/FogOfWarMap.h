@@ -0,0 +1,87 @@
+/*
+ * FogOfWarMap.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "int3.h"
+
+/// Tiles of map visible to one team, one bit per tile.
+/// Each level is a packed bitset of rows, so areas are revealed and combined word by word.
+class DLL_LINKAGE FogOfWarMap
+{
+public:
+	typedef ui64 TWord;
+	typedef std::function<void(const int3 &)> TTileFunction;
+
+	FogOfWarMap();
+	/// sizes are width, height and number of levels of map
+	explicit FogOfWarMap(const int3 & sizes);
+
+	/// Changes size of map, all tiles become hidden
+	void resize(const int3 & sizes);
+	const int3 & getSizes() const;
+
+	bool isVisible(const int3 & tile) const
+	{
+		const size_t bit = bitIndex(tile);
+		return (words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+	}
+
+	void setVisible(const int3 & tile, bool visible);
+	void setAll(bool visible);
+
+	/// Reveals tiles within radius of center on its level, same tiles as int3::DIST_2D range check gives.
+	/// Negative radius reveals whole map.
+	void revealCircle(const int3 & center, int radius);
+
+	/// Tiles visible in any of maps, both must be of same size
+	FogOfWarMap & operator|=(const FogOfWarMap & other);
+	/// Tiles visible in both maps
+	FogOfWarMap & operator&=(const FogOfWarMap & other);
+	/// Hides tiles visible in other map
+	FogOfWarMap & subtract(const FogOfWarMap & other);
+
+	/// Calls function for every tile with given visibility, words without such tiles are skipped
+	void forEachTile(bool visible, const TTileFunction & function) const;
+	/// Same as forEachTile but limited to area revealed by revealCircle
+	void forEachTileInCircle(const int3 & center, int radius, bool visible, const TTileFunction & function) const;
+
+	template <typename Handler> void serialize(Handler & h, const int version)
+	{
+		h & sizes;
+		h & words;
+		if(!h.saving)
+			wordsPerLevel = wordsForLevel(sizes);
+	}
+
+private:
+	static const size_t WORD_BITS = sizeof(TWord) * 8;
+
+	int3 sizes;
+	size_t wordsPerLevel; //every level starts with new word
+	std::vector<TWord> words;
+
+	static size_t wordsForLevel(const int3 & sizes);
+
+	size_t bitIndex(const int3 & tile) const
+	{
+		return tile.z * wordsPerLevel * WORD_BITS + tile.y * sizes.x + tile.x;
+	}
+
+	/// Visits rows of circle clipped to map: function(firstBit, lastBit) gets inclusive range of bits of one row
+	template<typename Function>
+	void forEachCircleRow(const int3 & center, int radius, const Function & function) const;
+
+	/// Visits words covering inclusive bit range: function(wordIndex, mask of bits in range)
+	template<typename Function>
+	static void forEachWord(size_t firstBit, size_t lastBit, const Function & function);
+
+	/// Calls function for tiles of set bits of word, padding bits at the end of level are ignored
+	void forEachSetBit(size_t wordIndex, TWord word, const TTileFunction & function) const;
+};
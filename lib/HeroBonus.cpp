@@ -23,6 +23,7 @@
 #include "CArtHandler.h"
 #include "StringConstants.h"
 #include "battle/BattleInfo.h"
+#include "serializer/LoadProfiler.h"
 
 #define FOREACH_PARENT(pname) 	TNodes lparents; getParents(lparents); for(CBonusSystemNode *pname : lparents)
 #define FOREACH_CPARENT(pname) 	TCNodes lparents; getParents(lparents); for(const CBonusSystemNode *pname : lparents)
@@ -212,10 +213,93 @@ JsonNode CAddInfo::toJsonNode() const
 	}
 }
 
-std::atomic<int32_t> CBonusSystemNode::treeChanged(1);
+BonusCacheKey::BonusCacheKey()
+	: BonusCacheKey(EKind::NONE, 0)
+{
+}
+
+BonusCacheKey::BonusCacheKey(const std::string & name)
+	: BonusCacheKey(EKind::NONE, 0)
+{
+	static boost::mutex mx;
+	static std::map<std::string, si32> names;
+
+	if(name.empty())
+		return;
+
+	boost::mutex::scoped_lock lock(mx);
+
+	auto it = names.find(name);
+	if(it == names.end())
+		it = names.insert(std::make_pair(name, static_cast<si32>(names.size()))).first;
+
+	kind = EKind::NAMED;
+	first = it->second;
+}
+
+BonusCacheKey::BonusCacheKey(const char * name)
+	: BonusCacheKey(std::string(name))
+{
+}
+
+BonusCacheKey::BonusCacheKey(EKind Kind, si32 First, si32 Second, si32 Third)
+	: kind(Kind),
+	first(First),
+	second(Second),
+	third(Third)
+{
+}
+
+BonusCacheKey BonusCacheKey::type(Bonus::BonusType type, TBonusSubtype subtype)
+{
+	return BonusCacheKey(EKind::TYPE, type, subtype);
+}
+
+BonusCacheKey BonusCacheKey::typeInfo(Bonus::BonusType type, TBonusSubtype subtype, si32 info)
+{
+	return BonusCacheKey(EKind::TYPE_INFO, type, subtype, info);
+}
+
+BonusCacheKey BonusCacheKey::typeTurns(Bonus::BonusType type, int turns)
+{
+	return BonusCacheKey(EKind::TYPE_TURNS, type, turns);
+}
+
+BonusCacheKey BonusCacheKey::source(Bonus::BonusSource source, ui32 sourceID)
+{
+	return BonusCacheKey(EKind::SOURCE, source, static_cast<si32>(sourceID));
+}
+
+BonusCacheKey BonusCacheKey::days(int days)
+{
+	return BonusCacheKey(EKind::DAYS, days);
+}
+
+bool BonusCacheKey::empty() const
+{
+	return kind == EKind::NONE;
+}
+
+bool BonusCacheKey::operator==(const BonusCacheKey & other) const
+{
+	return kind == other.kind && first == other.first && second == other.second && third == other.third;
+}
+
+bool BonusCacheKey::operator<(const BonusCacheKey & other) const
+{
+	return std::tie(kind, first, second, third) < std::tie(other.kind, other.first, other.second, other.third);
+}
+
+static bool requestKeyLess(const std::pair<BonusCacheKey, TBonusListPtr> & request, const BonusCacheKey & key)
+{
+	return request.first < key;
+}
+
+std::atomic<int64_t> CBonusSystemNode::treeChanged(1);
+std::atomic<int64_t> CBonusSystemNode::globalChanged(1);
 const bool CBonusSystemNode::cachingEnabled = true;
 
-BonusList::BonusList(bool BelongsToTree) : belongsToTree(BelongsToTree)
+BonusList::BonusList()
 {
 
 }
@@ -224,13 +308,10 @@ BonusList::BonusList(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
 }
 
-BonusList::BonusList(BonusList&& other):
-	belongsToTree(false)
+BonusList::BonusList(BonusList&& other)
 {
-	std::swap(belongsToTree, other.belongsToTree);
 	std::swap(bonuses, other.bonuses);
 }
 
@@ -238,16 +319,9 @@ BonusList& BonusList::operator=(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
 	return *this;
 }
 
-void BonusList::changed()
-{
-    if(belongsToTree)
-		CBonusSystemNode::treeHasChanged();
-}
-
 void BonusList::stackBonuses()
 {
 	boost::sort(bonuses, [](std::shared_ptr<Bonus> b1, std::shared_ptr<Bonus> b2) -> bool
@@ -395,12 +469,17 @@ void BonusList::getBonuses(BonusList & out, const CSelector &selector) const
 	getBonuses(out, selector, nullptr);
 }
 
+static bool isSelected(const Bonus * b, const CSelector & selector, const CSelector & limit)
+{
+	//matches limit predicate or has NO_LIMIT if no given predicate
+	return selector(b) && ((!limit && b->effectRange == Bonus::NO_LIMIT) || ((bool)limit && limit(b)));
+}
+
 void BonusList::getBonuses(BonusList & out, const CSelector &selector, const CSelector &limit) const
 {
 	for (auto & b : bonuses)
 	{
-		//add matching bonuses that matches limit predicate or have NO_LIMIT if no given predicate
-		if(selector(b.get()) && ((!limit && b->effectRange == Bonus::NO_LIMIT) || ((bool)limit && limit(b.get()))))
+		if(isSelected(b.get(), selector, limit))
 			out.push_back(b);
 	}
 }
@@ -430,19 +509,16 @@ JsonNode BonusList::toJsonNode() const
 void BonusList::push_back(std::shared_ptr<Bonus> x)
 {
 	bonuses.push_back(x);
-	changed();
 }
 
 BonusList::TInternalContainer::iterator BonusList::erase(const int position)
 {
-	changed();
 	return bonuses.erase(bonuses.begin() + position);
 }
 
 void BonusList::clear()
 {
 	bonuses.clear();
-	changed();
 }
 
 std::vector<BonusList*>::size_type BonusList::operator-=(std::shared_ptr<Bonus> const &i)
@@ -451,20 +527,17 @@ std::vector<BonusList*>::size_type BonusList::operator-=(std::shared_ptr<Bonus>
 	if(itr == bonuses.end())
 		return false;
 	bonuses.erase(itr);
-	changed();
 	return true;
 }
 
 void BonusList::resize(BonusList::TInternalContainer::size_type sz, std::shared_ptr<Bonus> c )
 {
 	bonuses.resize(sz, c);
-	changed();
 }
 
 void BonusList::insert(BonusList::TInternalContainer::iterator position, BonusList::TInternalContainer::size_type n, std::shared_ptr<Bonus> const &x)
 {
 	bonuses.insert(position, n, x);
-	changed();
 }
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector) const
@@ -474,59 +547,51 @@ int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector)
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, int subtype) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return valOfBonuses(s, cachingStr.str());
+	return valOfBonuses(s, BonusCacheKey::type(type, subtype));
 }
 
-int IBonusBearer::valOfBonuses(const CSelector &selector, const std::string &cachingStr) const
+int IBonusBearer::valOfBonuses(const CSelector &selector, const BonusCacheKey & cachingKey) const
 {
 	CSelector limit = nullptr;
-	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingStr);
+	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingKey);
 	return hlp->totalValue();
 }
-bool IBonusBearer::hasBonus(const CSelector &selector, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const BonusCacheKey & cachingKey) const
 {
-	return getBonuses(selector, cachingStr)->size() > 0;
+	return getBonuses(selector, cachingKey)->size() > 0;
 }
 
-bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey & cachingKey) const
 {
-	return getBonuses(selector, limit, cachingStr)->size() > 0;
+	return getBonuses(selector, limit, cachingKey)->size() > 0;
 }
 
 bool IBonusBearer::hasBonusOfType(Bonus::BonusType type, int subtype) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return hasBonus(s, cachingStr.str());
+	return hasBonus(s, BonusCacheKey::type(type, subtype));
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const std::string &cachingStr) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const BonusCacheKey & cachingKey) const
 {
-	return getAllBonuses(selector, nullptr, nullptr, cachingStr);
+	return getAllBonuses(selector, nullptr, nullptr, cachingKey);
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey & cachingKey) const
 {
-	return getAllBonuses(selector, limit, nullptr, cachingStr);
+	return getAllBonuses(selector, limit, nullptr, cachingKey);
 }
 
 bool IBonusBearer::hasBonusFrom(Bonus::BonusSource source, ui32 sourceID) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "source_" << source << "id_" << sourceID;
-	return hasBonus(Selector::source(source,sourceID), cachingStr.str());
+	return hasBonus(Selector::source(source,sourceID), BonusCacheKey::source(source, sourceID));
 }
 
 int IBonusBearer::MoraleVal() const
@@ -558,42 +623,42 @@ int IBonusBearer::LuckVal() const
 
 ui32 IBonusBearer::MaxHealth() const
 {
-	const std::string cachingStr = "type_STACK_HEALTH";
+	static const auto cachingKey = BonusCacheKey::type(Bonus::STACK_HEALTH);
 	static const auto selector = Selector::type(Bonus::STACK_HEALTH);
-	auto value = valOfBonuses(selector, cachingStr);
+	auto value = valOfBonuses(selector, cachingKey);
 	return std::max(1, value); //never 0
 }
 
 int IBonusBearer::getAttack(bool ranged) const
 {
-	const std::string cachingStr = "type_PRIMARY_SKILLs_ATTACK";
+	static const auto cachingKey = BonusCacheKey::type(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK);
 
 	static const auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK);
 
-	return getBonuses(selector, nullptr, cachingStr)->totalValue();
+	return getBonuses(selector, nullptr, cachingKey)->totalValue();
 }
 
 int IBonusBearer::getDefence(bool ranged) const
 {
-	const std::string cachingStr = "type_PRIMARY_SKILLs_DEFENSE";
+	static const auto cachingKey = BonusCacheKey::type(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE);
 
 	static const auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE);
 
-	return getBonuses(selector, nullptr, cachingStr)->totalValue();
+	return getBonuses(selector, nullptr, cachingKey)->totalValue();
 }
 
 int IBonusBearer::getMinDamage(bool ranged) const
 {
-	const std::string cachingStr = "type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_1";
+	static const BonusCacheKey cachingKey("type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_1");
 	static const auto selector = Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1));
-	return valOfBonuses(selector, cachingStr);
+	return valOfBonuses(selector, cachingKey);
 }
 
 int IBonusBearer::getMaxDamage(bool ranged) const
 {
-	const std::string cachingStr = "type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_2";
+	static const BonusCacheKey cachingKey("type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_2");
 	static const auto selector = Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2));
-	return valOfBonuses(selector, cachingStr);
+	return valOfBonuses(selector, cachingKey);
 }
 
 si32 IBonusBearer::manaLimit() const
@@ -616,29 +681,47 @@ si32 IBonusBearer::magicResistance() const
 	return valOfBonuses(Bonus::MAGIC_RESISTANCE);
 }
 
-ui32 IBonusBearer::Speed(int turn, bool useBind) const
+static ui32 speedImpl(const IBonusBearer * bearer, int turn, bool useBind, const CSelector & siegeWeapon, const CSelector & bindEffect, const CSelector & speed)
 {
 	//war machines cannot move
-	if(hasBonus(Selector::type(Bonus::SIEGE_WEAPON).And(Selector::turns(turn))))
+	if(bearer->hasBonus(siegeWeapon, BonusCacheKey::typeTurns(Bonus::SIEGE_WEAPON, turn)))
 	{
 		return 0;
 	}
 	//bind effect check - doesn't influence stack initiative
-	if(useBind && hasBonus(Selector::type(Bonus::BIND_EFFECT).And(Selector::turns(turn))))
+	if(useBind && bearer->hasBonus(bindEffect, BonusCacheKey::typeTurns(Bonus::BIND_EFFECT, turn)))
 	{
 		return 0;
 	}
 
-	return valOfBonuses(Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(turn)));
+	return bearer->valOfBonuses(speed, BonusCacheKey::typeTurns(Bonus::STACKS_SPEED, turn));
+}
+
+ui32 IBonusBearer::Speed(int turn, bool useBind) const
+{
+	//current turn is queried most of the time, do not rebuild its selectors
+	if(turn == 0)
+	{
+		static const auto siegeWeapon = Selector::type(Bonus::SIEGE_WEAPON).And(Selector::turns(0));
+		static const auto bindEffect = Selector::type(Bonus::BIND_EFFECT).And(Selector::turns(0));
+		static const auto speed = Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(0));
+
+		return speedImpl(this, turn, useBind, siegeWeapon, bindEffect, speed);
+	}
+
+	return speedImpl(this, turn, useBind,
+		Selector::type(Bonus::SIEGE_WEAPON).And(Selector::turns(turn)),
+		Selector::type(Bonus::BIND_EFFECT).And(Selector::turns(turn)),
+		Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(turn)));
 }
 
 bool IBonusBearer::isLiving() const //TODO: theoreticaly there exists "LIVING" bonus in stack experience documentation
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::UNDEAD << "s_-1Otype_" << Bonus::NON_LIVING << "s_-11type_" << Bonus::SIEGE_WEAPON; //I don't really get what string labels mean?
-	return !hasBonus(Selector::type(Bonus::UNDEAD)
+	static const BonusCacheKey cachingKey("type_UNDEADOtype_NON_LIVINGOtype_SIEGE_WEAPON");
+	static const auto selector = Selector::type(Bonus::UNDEAD)
 					.Or(Selector::type(Bonus::NON_LIVING))
-					.Or(Selector::type(Bonus::SIEGE_WEAPON)), cachingStr.str());
+					.Or(Selector::type(Bonus::SIEGE_WEAPON));
+	return !hasBonus(selector, cachingKey);
 }
 
 const std::shared_ptr<Bonus> IBonusBearer::getBonus(const CSelector &selector) const
@@ -712,36 +795,18 @@ void CBonusSystemNode::getAllBonusesRec(BonusList &out) const
 		out.push_back(update(b));
 }
 
-const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const std::string &cachingStr) const
+const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const BonusCacheKey & cachingKey) const
 {
 	bool limitOnUs = (!root || root == this); //caching won't work when we want to limit bonuses against an external node
 	if (CBonusSystemNode::cachingEnabled && limitOnUs)
 	{
-		// Exclusive access for one thread
-		static boost::mutex m;
-		boost::mutex::scoped_lock lock(m);
-
-		// If the bonus system tree changes(state of a single node or the relations to each other) then
-		// cache all bonus objects. Selector objects doesn't matter.
-		if (cachedLast != treeChanged)
-		{
-			cachedBonuses.clear();
-			cachedRequests.clear();
-
-			BonusList allBonuses;
-			getAllBonusesRec(allBonuses);
-			limitBonuses(allBonuses, cachedBonuses);
-			cachedBonuses.stackBonuses();
-
-			cachedLast = treeChanged;
-		}
-
 		// If a bonus system request comes with a caching string then look up in the map if there are any
 		// pre-calculated bonus results. Limiters can't be cached so they have to be calculated.
-		if (cachingStr != "")
+		if(!cachingKey.empty())
 		{
-			auto it = cachedRequests.find(cachingStr);
-			if(it != cachedRequests.end())
+			auto & entry = getThreadCacheEntry();
+			auto it = boost::lower_bound(entry.requests, cachingKey, requestKeyLess);
+			if(it != entry.requests.end() && it->first == cachingKey)
 			{
 				//Cached list contains bonuses for our query with applied limiters
 				return it->second;
@@ -750,12 +815,19 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 
 		//We still don't have the bonuses (didn't returned them from cache)
 		//Perform bonus selection
+		auto snapshot = getThreadCacheEntry().bonuses;
 		auto ret = std::make_shared<BonusList>();
-		cachedBonuses.getBonuses(*ret, selector, limit);
+		snapshot->getBonuses(*ret, selector, limit);
 
 		// Save the results in the cache
-		if(cachingStr != "")
-			cachedRequests[cachingStr] = ret;
+		// Entry is looked up again, selectors might have queried other nodes sharing the same slot
+		if(!cachingKey.empty())
+		{
+			auto & entry = getThreadCacheEntry();
+			auto it = boost::lower_bound(entry.requests, cachingKey, requestKeyLess);
+			if(it == entry.requests.end() || !(it->first == cachingKey))
+				entry.requests.insert(it, std::make_pair(cachingKey, ret));
+		}
 
 		return ret;
 	}
@@ -765,6 +837,127 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 	}
 }
 
+struct CBonusSystemNode::ThreadCache
+{
+	static const int SIZE_BITS = 9;
+	std::array<ThreadCacheEntry, 1 << SIZE_BITS> entries;
+
+	ThreadCacheEntry & entryFor(const CBonusSystemNode * node)
+	{
+		//nodes are large objects, low bits of their addresses are mostly equal
+		const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) * 0x9E3779B97F4A7C15ULL;
+		return entries[hash >> (64 - SIZE_BITS)];
+	}
+};
+
+CBonusSystemNode::ThreadCacheEntry & CBonusSystemNode::getThreadCacheEntry() const
+{
+	static boost::thread_specific_ptr<ThreadCache> threadCache;
+
+	const int64_t version = getTreeVersion();
+
+	if(!threadCache.get())
+		threadCache.reset(new ThreadCache());
+
+	auto & entry = threadCache->entryFor(this);
+	if(entry.node != this || entry.version != version)
+	{
+		//limiters may query other nodes and reuse this entry meanwhile
+		auto bonuses = getCachedBonuses(version);
+
+		entry.node = this;
+		entry.version = version;
+		entry.bonuses = bonuses;
+		entry.requests.clear();
+	}
+	return entry;
+}
+
+std::shared_ptr<const CBonusSystemNode::CachedBonuses> CBonusSystemNode::getCachedBonuses(int64_t version) const
+{
+	{
+		boost::mutex::scoped_lock lock(cacheMx);
+		if(cache && cache->version == version)
+			return cache;
+	}
+
+	// If the bonus system tree changes(state of a single node or the relations to each other) then
+	// cache all bonus objects. Selector objects doesn't matter.
+	// Built without lock, limiters may query other nodes. Threads racing here build equal snapshots.
+	auto fresh = std::make_shared<CachedBonuses>();
+	fresh->version = version;
+
+	BonusList allBonuses;
+	getAllBonusesRec(allBonuses);
+	limitBonuses(allBonuses, fresh->bonuses);
+	fresh->bonuses.stackBonuses();
+	fresh->buildIndex();
+
+	boost::mutex::scoped_lock lock(cacheMx);
+	cache = fresh;
+	return fresh;
+}
+
+struct BonusSubtypeLess
+{
+	bool operator()(const std::shared_ptr<Bonus> & lhs, const std::shared_ptr<Bonus> & rhs) const
+	{
+		return lhs->subtype < rhs->subtype;
+	}
+	bool operator()(const std::shared_ptr<Bonus> & lhs, TBonusSubtype rhs) const
+	{
+		return lhs->subtype < rhs;
+	}
+	bool operator()(TBonusSubtype lhs, const std::shared_ptr<Bonus> & rhs) const
+	{
+		return lhs < rhs->subtype;
+	}
+};
+
+void CBonusSystemNode::CachedBonuses::buildIndex()
+{
+	for(auto & b : bonuses)
+	{
+		const size_t type = b->type;
+		if(type >= byType.size())
+			byType.resize(type + 1);
+		byType[type].push_back(b);
+	}
+
+	byTypeSubtype = byType;
+	for(auto & group : byTypeSubtype)
+		std::stable_sort(group.begin(), group.end(), BonusSubtypeLess());
+}
+
+void CBonusSystemNode::CachedBonuses::getBonuses(BonusList & out, const CSelector & selector, const CSelector & limit) const
+{
+	const si32 type = selector.getTypeHint();
+	const si32 subtype = selector.getSubtypeHint();
+
+	if(type == CSelector::NO_HINT)
+	{
+		bonuses.getBonuses(out, selector, limit);
+		return;
+	}
+
+	if(type < 0 || static_cast<size_t>(type) >= byType.size())
+		return;
+
+	auto range = boost::make_iterator_range(byType[type]);
+
+	if(subtype != CSelector::NO_HINT)
+	{
+		const auto & group = byTypeSubtype[type];
+		range = boost::make_iterator_range(std::equal_range(group.begin(), group.end(), subtype, BonusSubtypeLess()));
+	}
+
+	for(auto & b : range)
+	{
+		if(isSelected(b.get(), selector, limit))
+			out.push_back(b);
+	}
+}
+
 const TBonusListPtr CBonusSystemNode::getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root) const
 {
 	auto ret = std::make_shared<BonusList>();
@@ -807,18 +1000,14 @@ const std::shared_ptr<Bonus> CBonusSystemNode::update(const std::shared_ptr<Bonu
 }
 
 CBonusSystemNode::CBonusSystemNode()
-	: bonuses(true),
-	exportedBonuses(true),
-	nodeType(UNKNOWN),
-	cachedLast(0)
+	: nodeType(UNKNOWN),
+	nodeChanged(++treeChanged)
 {
 }
 
 CBonusSystemNode::CBonusSystemNode(ENodeTypes NodeType)
-	: bonuses(true),
-	exportedBonuses(true),
-	nodeType(NodeType),
-	cachedLast(0)
+	: nodeType(NodeType),
+	nodeChanged(++treeChanged)
 {
 }
 
@@ -827,7 +1016,7 @@ CBonusSystemNode::CBonusSystemNode(CBonusSystemNode && other):
 	exportedBonuses(std::move(other.exportedBonuses)),
 	nodeType(other.nodeType),
 	description(other.description),
-	cachedLast(0)
+	nodeChanged(++treeChanged)
 {
 	std::swap(parents, other.parents);
 	std::swap(children, other.children);
@@ -847,9 +1036,6 @@ CBonusSystemNode::CBonusSystemNode(CBonusSystemNode && other):
 	}
 
 	//cache ignored
-
-	//cachedBonuses
-	//cachedRequests
 }
 
 CBonusSystemNode::~CBonusSystemNode()
@@ -874,7 +1060,7 @@ void CBonusSystemNode::attachTo(CBonusSystemNode *parent)
 		newRedDescendant(parent);
 
 	parent->newChildAttached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
@@ -888,7 +1074,7 @@ void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
 
 	parents -= parent;
 	parent->childDetached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::removeBonusesRecursive(const CSelector & s)
@@ -902,13 +1088,22 @@ void CBonusSystemNode::reduceBonusDurations(const CSelector &s)
 {
 	BonusList bl;
 	exportedBonuses.getBonuses(bl, s, Selector::all);
+	bool changed = false;
 	for(auto b : bl)
 	{
 		b->turnsRemain--;
 		if(b->turnsRemain <= 0)
 			removeBonus(b);
+		else if(b->propagator)
+			propagatedBonusChanged(b);
+		else
+			changed = true;
 	}
 
+	//remaining bonuses were modified in place
+	if(changed)
+		nodeHasChanged();
+
 	for(CBonusSystemNode *child : children)
 		child->reduceBonusDurations(s);
 }
@@ -924,14 +1119,19 @@ void CBonusSystemNode::addNewBonus(const std::shared_ptr<Bonus>& b)
 	assert(!vstd::contains(exportedBonuses, b));
 	exportedBonuses.push_back(b);
 	exportBonus(b);
-	CBonusSystemNode::treeHasChanged();
 }
 
 void CBonusSystemNode::accumulateBonus(const std::shared_ptr<Bonus>& b)
 {
 	auto bonus = exportedBonuses.getFirst(Selector::typeSubtype(b->type, b->subtype)); //only local bonuses are interesting //TODO: what about value type?
 	if(bonus)
+	{
 		bonus->val += b->val;
+		if(bonus->propagator)
+			propagatedBonusChanged(bonus);
+		else
+			nodeHasChanged();
+	}
 	else
 		addNewBonus(std::make_shared<Bonus>(*b)); //duplicate needed, original may get destroyed
 }
@@ -940,10 +1140,14 @@ void CBonusSystemNode::removeBonus(const std::shared_ptr<Bonus>& b)
 {
 	exportedBonuses -= b;
 	if(b->propagator)
+	{
 		unpropagateBonus(b);
+	}
 	else
+	{
 		bonuses -= b;
-	CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
+	}
 }
 
 void CBonusSystemNode::removeBonuses(const CSelector & selector)
@@ -972,6 +1176,7 @@ void CBonusSystemNode::propagateBonus(std::shared_ptr<Bonus> b)
 	if(b->propagator->shouldBeAttached(this))
 	{
 		bonuses.push_back(b);
+		nodeHasChanged();
 		logBonus->trace("#$# %s #propagated to# %s",  b->Description(), nodeName());
 	}
 
@@ -984,6 +1189,7 @@ void CBonusSystemNode::unpropagateBonus(std::shared_ptr<Bonus> b)
 	if(b->propagator->shouldBeAttached(this))
 	{
 		bonuses -= b;
+		nodeHasChanged();
 		logBonus->trace("#$# %s #is no longer propagated to# %s",  b->Description(), nodeName());
 	}
 
@@ -991,6 +1197,15 @@ void CBonusSystemNode::unpropagateBonus(std::shared_ptr<Bonus> b)
 		child->unpropagateBonus(b);
 }
 
+void CBonusSystemNode::propagatedBonusChanged(std::shared_ptr<Bonus> b)
+{
+	if(b->propagator->shouldBeAttached(this))
+		nodeHasChanged();
+
+	FOREACH_RED_CHILD(child)
+		child->propagatedBonusChanged(b);
+}
+
 void CBonusSystemNode::newChildAttached(CBonusSystemNode *child)
 {
 	assert(!vstd::contains(children, child));
@@ -1029,6 +1244,7 @@ std::string CBonusSystemNode::nodeName() const
 
 void CBonusSystemNode::deserializationFix()
 {
+	LoadProfilerSection section("deserializationFix");
 	exportBonuses();
 
 }
@@ -1108,11 +1324,14 @@ void CBonusSystemNode::getRedDescendants(TNodes &out)
 void CBonusSystemNode::exportBonus(std::shared_ptr<Bonus> b)
 {
 	if(b->propagator)
+	{
 		propagateBonus(b);
+	}
 	else
+	{
 		bonuses.push_back(b);
-
-	CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
+	}
 }
 
 void CBonusSystemNode::exportBonuses()
@@ -1205,13 +1424,35 @@ TBonusListPtr CBonusSystemNode::limitBonuses(const BonusList &allBonuses) const
 
 void CBonusSystemNode::treeHasChanged()
 {
-	treeChanged++;
+	globalChanged = ++treeChanged;
+}
+
+void CBonusSystemNode::nodeHasChanged()
+{
+	invalidateSubtree(++treeChanged);
+}
+
+int64_t CBonusSystemNode::nextTreeVersion()
+{
+	return ++treeChanged;
+}
+
+void CBonusSystemNode::invalidateSubtree(int64_t version)
+{
+	//subtree already reached through another parent
+	if(nodeChanged == version)
+		return;
+
+	nodeChanged = version;
+
+	//children inherit our bonuses
+	for(CBonusSystemNode * child : children)
+		child->invalidateSubtree(version);
 }
 
 int64_t CBonusSystemNode::getTreeVersion() const
 {
-	int64_t ret = treeChanged;
-	return ret << 32;
+	return std::max<int64_t>(nodeChanged, globalChanged);
 }
 
 int NBonus::valOf(const CBonusSystemNode *obj, Bonus::BonusType type, int subtype)
@@ -1431,14 +1672,15 @@ namespace Selector
 
 	CSelector DLL_LINKAGE typeSubtype(Bonus::BonusType Type, TBonusSubtype Subtype)
 	{
-		return type(Type).And(subtype(Subtype));
+		return type(Type).And(subtype(Subtype)).withTypeHint(Type, Subtype);
 	}
 
 	CSelector DLL_LINKAGE typeSubtypeInfo(Bonus::BonusType type, TBonusSubtype subtype, CAddInfo info)
 	{
 		return CSelectFieldEqual<Bonus::BonusType>(&Bonus::type)(type)
 			.And(CSelectFieldEqual<TBonusSubtype>(&Bonus::subtype)(subtype))
-			.And(CSelectFieldEqual<CAddInfo>(&Bonus::additionalInfo)(info));
+			.And(CSelectFieldEqual<CAddInfo>(&Bonus::additionalInfo)(info))
+			.withTypeHint(type, subtype);
 	}
 
 	CSelector DLL_LINKAGE source(Bonus::BonusSource source, ui32 sourceID)
@@ -33,27 +33,66 @@ class CSelector : std::function<bool(const Bonus*)>
 {
 	typedef std::function<bool(const Bonus*)> TBase;
 public:
-	CSelector() {}
+	enum { NO_HINT = std::numeric_limits<si32>::min() }; //no type or subtype hint
+
+	CSelector()
+		: typeHint(NO_HINT), subtypeHint(NO_HINT)
+	{}
 	template<typename T>
 	CSelector(const T &t,	//SFINAE trick -> include this c-tor in overload resolution only if parameter is class
 							//(includes functors, lambdas) or function. Without that VC is going mad about ambiguities.
 		typename std::enable_if < boost::mpl::or_ < std::is_class<T>, std::is_function<T >> ::value>::type *dummy = nullptr)
-		: TBase(t)
+		: TBase(t), typeHint(NO_HINT), subtypeHint(NO_HINT)
 	{}
 
 	CSelector(std::nullptr_t)
+		: typeHint(NO_HINT), subtypeHint(NO_HINT)
 	{}
 
 	CSelector And(CSelector rhs) const
 	{
 		//lambda may likely outlive "this" (it can be even a temporary) => we copy the OBJECT (not pointer)
 		auto thisCopy = *this;
-		return [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) && rhs(b); };
+		CSelector ret = [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) && rhs(b); };
+
+		//both must match, so any hint still holds - keep the more specific one
+		const CSelector & hint = (rhs.subtypeHint != NO_HINT || typeHint == NO_HINT) ? rhs : *this;
+		ret.typeHint = hint.typeHint;
+		ret.subtypeHint = hint.subtypeHint;
+		return ret;
 	}
 	CSelector Or(CSelector rhs) const
 	{
 		auto thisCopy = *this;
-		return [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) || rhs(b); };
+		CSelector ret = [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) || rhs(b); };
+
+		//either may match, hint holds only if shared
+		if(typeHint == rhs.typeHint)
+		{
+			ret.typeHint = typeHint;
+			ret.subtypeHint = subtypeHint == rhs.subtypeHint ? subtypeHint : NO_HINT;
+		}
+		return ret;
+	}
+
+	///declares that every selected bonus has given type and, unless NO_HINT, subtype
+	///bonus indexes use it to check only bonuses of that type
+	CSelector withTypeHint(si32 type, si32 subtype = NO_HINT) const
+	{
+		CSelector ret = *this;
+		ret.typeHint = type;
+		ret.subtypeHint = subtype;
+		return ret;
+	}
+
+	si32 getTypeHint() const
+	{
+		return typeHint;
+	}
+
+	si32 getSubtypeHint() const
+	{
+		return subtypeHint;
 	}
 
 	bool operator()(const Bonus *b) const
@@ -65,6 +104,10 @@ public:
 	{
 		return !!static_cast<const TBase&>(*this);
 	}
+
+private:
+	si32 typeHint;
+	si32 subtypeHint;
 };
 
 class DLL_LINKAGE CBonusProxy
@@ -476,8 +519,6 @@ public:
 
 private:
 	TInternalContainer bonuses;
-	bool belongsToTree;
-	void changed();
 
 public:
 	typedef TInternalContainer::const_reference const_reference;
@@ -486,7 +527,7 @@ public:
 	typedef TInternalContainer::const_iterator const_iterator;
 	typedef TInternalContainer::iterator iterator;
 
-	BonusList(bool BelongsToTree = false);
+	BonusList();
 	BonusList(const BonusList &bonusList);
 	BonusList(BonusList && other);
 	BonusList& operator=(const BonusList &bonusList);
@@ -636,6 +677,42 @@ public:
 	}
 };
 
+/// Identifies a cached bonus request on a node, requests with the same key must use the same selector.
+/// Structured keys are built without allocations. Named keys are interned under a global lock on construction,
+/// so they have to be kept in static variables.
+class DLL_LINKAGE BonusCacheKey
+{
+public:
+	BonusCacheKey(); //request is not cached
+	explicit BonusCacheKey(const std::string & name);
+	explicit BonusCacheKey(const char * name);
+
+	//subtype -1 means any subtype
+	static BonusCacheKey type(Bonus::BonusType type, TBonusSubtype subtype = -1);
+	static BonusCacheKey typeInfo(Bonus::BonusType type, TBonusSubtype subtype, si32 info);
+	static BonusCacheKey typeTurns(Bonus::BonusType type, int turns);
+	static BonusCacheKey source(Bonus::BonusSource source, ui32 sourceID);
+	static BonusCacheKey days(int days);
+
+	bool empty() const;
+
+	bool operator==(const BonusCacheKey & other) const;
+	bool operator<(const BonusCacheKey & other) const;
+
+private:
+	enum class EKind : ui8
+	{
+		NONE, NAMED, TYPE, TYPE_INFO, TYPE_TURNS, SOURCE, DAYS
+	};
+
+	BonusCacheKey(EKind Kind, si32 First, si32 Second = 0, si32 Third = 0);
+
+	EKind kind;
+	si32 first;
+	si32 second;
+	si32 third;
+};
+
 class DLL_LINKAGE IBonusBearer
 {
 public:
@@ -643,12 +720,12 @@ public:
 	// * selector is predicate that tests if HeroBonus matches our criteria
 	// * root is node on which call was made (nullptr will be replaced with this)
 	//interface
-	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const = 0;
-	int valOfBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
+	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const = 0;
+	int valOfBonuses(const CSelector &selector, const BonusCacheKey & cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const BonusCacheKey & cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey & cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey & cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const BonusCacheKey & cachingKey = BonusCacheKey()) const;
 
 	const std::shared_ptr<Bonus> getBonus(const CSelector &selector) const; //returns any bonus visible on node that matches (or nullptr if none matches)
 
@@ -698,19 +775,56 @@ private:
 	std::string description;
 
 	static const bool cachingEnabled;
-	mutable BonusList cachedBonuses;
-	mutable int64_t cachedLast;
-	static std::atomic<int32_t> treeChanged;
 
-	// Setting a value to cachingStr before getting any bonuses caches the result for later requests.
-	// This string needs to be unique, that's why it has to be setted in the following manner:
-	// [property key]_[value] => only for selector
-	mutable std::map<std::string, TBonusListPtr > cachedRequests;
+	// Immutable snapshot of all limited bonuses of this node for one tree version.
+	// Shared by all threads, each thread keeps its own reference in ThreadCacheEntry.
+	struct CachedBonuses
+	{
+		int64_t version;
+		BonusList bonuses;
+
+		// Bonuses grouped by type in original order, and grouped by type sorted by subtype.
+		// Selectors with type hint check only their group instead of all bonuses.
+		std::vector<BonusList::TInternalContainer> byType;
+		std::vector<BonusList::TInternalContainer> byTypeSubtype;
+
+		void buildIndex();
+		void getBonuses(BonusList & out, const CSelector & selector, const CSelector & limit) const;
+	};
+
+	// Per-thread view of a node cache, so that cached lookups never synchronize with other threads.
+	// Entries are identified by node address and tree version, versions are unique for each node lifetime.
+	struct ThreadCacheEntry
+	{
+		const CBonusSystemNode * node = nullptr;
+		int64_t version = 0;
+		std::shared_ptr<const CachedBonuses> bonuses;
+
+		// Passing a cachingKey when getting bonuses caches the result for later requests.
+		// Sorted by key, small enough to be searched faster than a tree.
+		std::vector<std::pair<BonusCacheKey, TBonusListPtr>> requests;
+	};
+	struct ThreadCache;
+
+	//latest snapshot, used only when a thread has no valid entry for this node
+	mutable boost::mutex cacheMx;
+	mutable std::shared_ptr<const CachedBonuses> cache;
+
+	// Version of the last change of this node or of any of its ancestors.
+	// Changes are versioned from the same counter as global ones, so a cache is valid
+	// only as long as neither this subtree nor the whole tree has changed since it was built.
+	// New nodes start with a fresh version, so no version is shared by two nodes at the same address.
+	std::atomic<int64_t> nodeChanged;
+	static std::atomic<int64_t> treeChanged;
+	static std::atomic<int64_t> globalChanged;
 
 	void getBonusesRec(BonusList &out, const CSelector &selector, const CSelector &limit) const;
 	void getAllBonusesRec(BonusList &out) const;
 	const TBonusListPtr getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr) const;
 	const std::shared_ptr<Bonus> update(const std::shared_ptr<Bonus> b) const;
+	std::shared_ptr<const CachedBonuses> getCachedBonuses(int64_t version) const;
+	ThreadCacheEntry & getThreadCacheEntry() const;
+	void invalidateSubtree(int64_t version);
 
 public:
 	explicit CBonusSystemNode();
@@ -720,7 +834,7 @@ public:
 
 	void limitBonuses(const BonusList &allBonuses, BonusList &out) const; //out will bo populed with bonuses that are not limited here
 	TBonusListPtr limitBonuses(const BonusList &allBonuses) const; //same as above, returns out by val for convienence
-	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const override;
+	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override;
 	void getParents(TCNodes &out) const;  //retrieves list of parent nodes (nodes to inherit bonuses from),
 	const std::shared_ptr<Bonus> getBonusLocalFirst(const CSelector &selector) const;
 
@@ -742,6 +856,7 @@ public:
 	void childDetached(CBonusSystemNode *child);
 	void propagateBonus(std::shared_ptr<Bonus> b);
 	void unpropagateBonus(std::shared_ptr<Bonus> b);
+	void propagatedBonusChanged(std::shared_ptr<Bonus> b); //invalidates nodes the bonus was propagated to after it was modified in place
 	void removeBonus(const std::shared_ptr<Bonus>& b);
 	void removeBonuses(const CSelector & selector);
 	void removeBonusesRecursive(const CSelector & s);
@@ -768,7 +883,12 @@ public:
 	const std::string &getDescription() const;
 	void setDescription(const std::string &description);
 
+	///invalidates bonus caches of every node in the game
 	static void treeHasChanged();
+	///invalidates bonus caches of this node and of all nodes inheriting bonuses from it
+	void nodeHasChanged();
+	///version newer than any current tree version, for bearers that version their own changes on top of the tree
+	static int64_t nextTreeVersion();
 
 	int64_t getTreeVersion() const override;
 
@@ -810,6 +930,15 @@ public:
 	}
 };
 
+//the only BonusType field is Bonus::type, selectors on it can be looked up in bonus indexes
+template<>
+inline CSelector CSelectFieldEqual<Bonus::BonusType>::operator()(const Bonus::BonusType &valueToCompareAgainst) const
+{
+	auto ptr2 = ptr;
+	CSelector ret = [ptr2, valueToCompareAgainst](const Bonus *bonus) {  return bonus->*ptr2 == valueToCompareAgainst; };
+	return ret.withTypeHint(valueToCompareAgainst);
+}
+
 template<typename T> //can be same, needed for subtype field
 class CSelectFieldEqualOrEvery
 {
@@ -1098,7 +1227,6 @@ template <class InputIterator>
 void BonusList::insert(const int position, InputIterator first, InputIterator last)
 {
 	bonuses.insert(bonuses.begin() + position, first, last);
-	changed();
 }
 
 // observers for updating bonuses based on certain events (e.g. hero gaining level)
@@ -64,6 +64,14 @@ void CPrivilegedInfoCallback::getTilesInRange(std::unordered_set<int3, ShashInt3
 	}
 	if (radious == -1) //reveal entire map
 		getAllTiles (tiles, player, -1, 0);
+	else if(player && mode != 0 && radious >= 0 && distanceFormula == int3::DIST_2D)
+	{
+		//visibility is checked word by word
+		gs->getPlayerTeam(*player)->fogOfWarMap.forEachTileInCircle(pos, radious, mode == -1, [&tiles](const int3 & tile)
+		{
+			tiles.insert(tile);
+		});
+	}
 	else
 	{
 		const TeamState * team = !player ? nullptr : gs->getPlayerTeam(*player);
@@ -77,8 +85,8 @@ void CPrivilegedInfoCallback::getTilesInRange(std::unordered_set<int3, ShashInt3
 				if(distance <= radious)
 				{
 					if(!player
-						|| (mode == 1  && team->fogOfWarMap[xd][yd][pos.z]==0)
-						|| (mode == -1 && team->fogOfWarMap[xd][yd][pos.z]==1)
+						|| (mode == 1  && !team->fogOfWarMap.isVisible(int3(xd, yd, pos.z)))
+						|| (mode == -1 && team->fogOfWarMap.isVisible(int3(xd, yd, pos.z)))
 					)
 						tiles.insert(int3(xd,yd,pos.z));
 				}
@@ -161,16 +169,28 @@ void CPrivilegedInfoCallback::loadCommonState(Loader & in)
 	StartInfo *si;
 
 	logGlobal->info("\tReading header");
-	in.serializer & dum;
+	{
+		LoadProfilerSection section("header");
+		in.serializer & dum;
+	}
 
 	logGlobal->info("\tReading options");
-	in.serializer & si;
+	{
+		LoadProfilerSection section("options");
+		in.serializer & si;
+	}
 
 	logGlobal->info("\tReading handlers");
-	in.serializer & *VLC;
+	{
+		LoadProfilerSection section("handlers");
+		in.serializer & *VLC;
+	}
 
 	logGlobal->info("\tReading gamestate");
-	in.serializer & gs;
+	{
+		LoadProfilerSection section("gamestate");
+		in.serializer & gs;
+	}
 }
 
 template<typename Saver>
@@ -192,6 +212,7 @@ void CPrivilegedInfoCallback::saveCommonState(Saver & out) const
 template DLL_LINKAGE void CPrivilegedInfoCallback::loadCommonState<CLoadIntegrityValidator>(CLoadIntegrityValidator &);
 template DLL_LINKAGE void CPrivilegedInfoCallback::loadCommonState<CLoadFile>(CLoadFile &);
 template DLL_LINKAGE void CPrivilegedInfoCallback::saveCommonState<CSaveFile>(CSaveFile &) const;
+template DLL_LINKAGE void CPrivilegedInfoCallback::saveCommonState<CSaveBuffer>(CSaveBuffer &) const;
 
 TerrainTile * CNonConstInfoCallback::getTile( int3 pos )
 {
@@ -47,7 +47,7 @@ void JsonWriter::writeEntry(JsonMap::const_iterator entry)
 		if (!entry->second.meta.empty())
 			out << prefix << " // " << entry->second.meta << "\n";
 		if(!entry->second.flags.empty())
-			out << prefix << " // flags: " << boost::algorithm::join(entry->second.flags, ", ") << "\n";
+			out << prefix << " // flags: " << boost::algorithm::join(entry->second.flags.get(), ", ") << "\n";
 		out << prefix;
 	}
 	writeString(entry->first);
@@ -62,7 +62,7 @@ void JsonWriter::writeEntry(JsonVector::const_iterator entry)
 		if (!entry->meta.empty())
 			out << prefix << " // " << entry->meta << "\n";
 		if(!entry->flags.empty())
-			out << prefix << " // flags: " << boost::algorithm::join(entry->flags, ", ") << "\n";
+			out << prefix << " // flags: " << boost::algorithm::join(entry->flags.get(), ", ") << "\n";
 		out << prefix;
 	}
 	writeNode(*entry);
@@ -149,17 +149,106 @@ JsonWriter::JsonWriter(std::ostream & output, bool compact)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void JsonTreeBuilder::onNull()
+{
+	nextNode().clear();
+}
+
+void JsonTreeBuilder::onBool(bool value)
+{
+	nextNode().Bool() = value;
+}
+
+void JsonTreeBuilder::onInteger(si64 value)
+{
+	JsonNode & node = nextNode();
+	node.setType(JsonNode::JsonType::DATA_INTEGER);
+	node.Integer() = value;
+}
+
+void JsonTreeBuilder::onFloat(double value)
+{
+	JsonNode & node = nextNode();
+	node.setType(JsonNode::JsonType::DATA_FLOAT);
+	node.Float() = value;
+}
+
+void JsonTreeBuilder::onString(std::string & value)
+{
+	JsonNode & node = nextNode();
+	node.setType(JsonNode::JsonType::DATA_STRING);
+	node.String() = std::move(value);
+}
+
+void JsonTreeBuilder::onStructBegin()
+{
+	JsonNode & node = nextNode();
+	node.setType(JsonNode::JsonType::DATA_STRUCT);
+	containers.push_back(&node);
+}
+
+bool JsonTreeBuilder::onStructKey(const std::string & key, const std::vector<std::string> & flags)
+{
+	JsonMap & object = containers.back()->Struct();
+	auto inserted = object.insert(std::make_pair(key, JsonNode()));
+	keyNode = &inserted.first->second;
+	if (!flags.empty())
+		keyNode->flags = flags;
+	return inserted.second;
+}
+
+void JsonTreeBuilder::onStructEnd()
+{
+	containers.pop_back();
+}
+
+void JsonTreeBuilder::onArrayBegin()
+{
+	JsonNode & node = nextNode();
+	node.setType(JsonNode::JsonType::DATA_VECTOR);
+	containers.push_back(&node);
+}
+
+void JsonTreeBuilder::onArrayEnd()
+{
+	containers.pop_back();
+}
+
+JsonNode & JsonTreeBuilder::nextNode()
+{
+	if (containers.empty())
+		return root;
+
+	JsonNode & container = *containers.back();
+	if (container.getType() == JsonNode::JsonType::DATA_VECTOR)
+	{
+		container.Vector().emplace_back();
+		return container.Vector().back();
+	}
+	return *keyNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 JsonParser::JsonParser(const char * inputString, size_t stringSize):
 	input(inputString, stringSize),
 	lineCount(1),
 	lineStart(0),
-	pos(0)
+	pos(0),
+	handler(nullptr)
 {
 }
 
 JsonNode JsonParser::parse(std::string fileName)
 {
-	JsonNode root;
+	JsonTreeBuilder builder;
+	parse(fileName, builder);
+	return std::move(builder.root);
+}
+
+void JsonParser::parse(std::string fileName, IJsonEventHandler & eventHandler)
+{
+	handler = &eventHandler;
 
 	if (input.size() == 0)
 	{
@@ -170,7 +259,7 @@ JsonNode JsonParser::parse(std::string fileName)
 		if (!Unicode::isValidString(&input[0], input.size()))
 			error("Not a valid UTF-8 file", false);
 
-		extractValue(root);
+		extractValue();
 		extractWhitespace(false);
 
 		//Warn if there are any non-whitespace symbols left
@@ -183,7 +272,7 @@ JsonNode JsonParser::parse(std::string fileName)
 		logMod->warn("File %s is not a valid JSON file!", fileName);
 		logMod->warn(errors);
 	}
-	return root;
+	handler = nullptr;
 }
 
 bool JsonParser::isValid()
@@ -203,24 +292,24 @@ bool JsonParser::extractSeparator()
 	return true;
 }
 
-bool JsonParser::extractValue(JsonNode &node)
+bool JsonParser::extractValue()
 {
 	if (!extractWhitespace())
 		return false;
 
 	switch (input[pos])
 	{
-		case '\"': return extractString(node);
-		case 'n' : return extractNull(node);
-		case 't' : return extractTrue(node);
-		case 'f' : return extractFalse(node);
-		case '{' : return extractStruct(node);
-		case '[' : return extractArray(node);
-		case '-' : return extractFloat(node);
+		case '\"': return extractStringValue();
+		case 'n' : return extractNull();
+		case 't' : return extractTrue();
+		case 'f' : return extractFalse();
+		case '{' : return extractStruct();
+		case '[' : return extractArray();
+		case '-' : return extractFloat();
 		default:
 		{
 			if (input[pos] >= '0' && input[pos] <= '9')
-				return extractFloat(node);
+				return extractFloat();
 			return error("Value expected!");
 		}
 	}
@@ -317,14 +406,13 @@ bool JsonParser::extractString(std::string &str)
 	return error("Unterminated string!");
 }
 
-bool JsonParser::extractString(JsonNode &node)
+bool JsonParser::extractStringValue()
 {
 	std::string str;
 	if (!extractString(str))
 		return false;
 
-	node.setType(JsonNode::JsonType::DATA_STRING);
-	node.String() = str;
+	handler->onString(str);
 	return true;
 }
 
@@ -342,36 +430,36 @@ bool JsonParser::extractLiteral(const std::string &literal)
 	return true;
 }
 
-bool JsonParser::extractNull(JsonNode &node)
+bool JsonParser::extractNull()
 {
 	if (!extractLiteral("null"))
 		return false;
 
-	node.clear();
+	handler->onNull();
 	return true;
 }
 
-bool JsonParser::extractTrue(JsonNode &node)
+bool JsonParser::extractTrue()
 {
 	if (!extractLiteral("true"))
 		return false;
 
-	node.Bool() = true;
+	handler->onBool(true);
 	return true;
 }
 
-bool JsonParser::extractFalse(JsonNode &node)
+bool JsonParser::extractFalse()
 {
 	if (!extractLiteral("false"))
 		return false;
 
-	node.Bool() = false;
+	handler->onBool(false);
 	return true;
 }
 
-bool JsonParser::extractStruct(JsonNode &node)
+bool JsonParser::extractStruct()
 {
-	node.setType(JsonNode::JsonType::DATA_STRUCT);
+	handler->onStructBegin();
 	pos++;
 
 	if (!extractWhitespace())
@@ -381,6 +469,7 @@ bool JsonParser::extractStruct(JsonNode &node)
 	if (input[pos] == '}')
 	{
 		pos++;
+		handler->onStructEnd();
 		return true;
 	}
 
@@ -394,42 +483,44 @@ bool JsonParser::extractStruct(JsonNode &node)
 			return false;
 
 		// split key string into actual key and meta-flags
-		std::vector<std::string> keyAndFlags;
-		boost::split(keyAndFlags, key, boost::is_any_of("#"));
-		key = keyAndFlags[0];
+		std::vector<std::string> flags;
+		const size_t flagsStart = key.find('#');
+		if (flagsStart != std::string::npos)
+		{
+			boost::split(flags, key.substr(flagsStart + 1), boost::is_any_of("#"));
+			key.resize(flagsStart);
+		}
 		// check for unknown flags - helps with debugging
-		std::vector<std::string> knownFlags = { "override" };
-		for(int i = 1; i < keyAndFlags.size(); i++)
+		static const std::vector<std::string> knownFlags = { "override" };
+		for(const std::string & flag : flags)
 		{
-			if(!vstd::contains(knownFlags, keyAndFlags[i]))
-				error("Encountered unknown flag #" + keyAndFlags[i], true);
+			if(!vstd::contains(knownFlags, flag))
+				error("Encountered unknown flag #" + flag, true);
 		}
 
-		if (node.Struct().find(key) != node.Struct().end())
+		// flags from key string belong to referenced element
+		if (!handler->onStructKey(key, flags))
 			error("Dublicated element encountered!", true);
 
 		if (!extractSeparator())
 			return false;
 
-		if (!extractElement(node.Struct()[key], '}'))
+		if (!extractElement('}'))
 			return false;
 
-		// flags from key string belong to referenced element
-		for(int i = 1; i < keyAndFlags.size(); i++)
-			node.Struct()[key].flags.push_back(keyAndFlags[i]);
-
 		if (input[pos] == '}')
 		{
 			pos++;
+			handler->onStructEnd();
 			return true;
 		}
 	}
 }
 
-bool JsonParser::extractArray(JsonNode &node)
+bool JsonParser::extractArray()
 {
 	pos++;
-	node.setType(JsonNode::JsonType::DATA_VECTOR);
+	handler->onArrayBegin();
 
 	if (!extractWhitespace())
 		return false;
@@ -438,29 +529,27 @@ bool JsonParser::extractArray(JsonNode &node)
 	if (input[pos] == ']')
 	{
 		pos++;
+		handler->onArrayEnd();
 		return true;
 	}
 
 	while (true)
 	{
-		//NOTE: currently 50% of time is this vector resizing.
-		//May be useful to use list during parsing and then swap() all items to vector
-		node.Vector().resize(node.Vector().size()+1);
-
-		if (!extractElement(node.Vector().back(), ']'))
+		if (!extractElement(']'))
 			return false;
 
 		if (input[pos] == ']')
 		{
 			pos++;
+			handler->onArrayEnd();
 			return true;
 		}
 	}
 }
 
-bool JsonParser::extractElement(JsonNode &node, char terminator)
+bool JsonParser::extractElement(char terminator)
 {
-	if (!extractValue(node))
+	if (!extractValue())
 		return false;
 
 	if (!extractWhitespace())
@@ -488,7 +577,7 @@ bool JsonParser::extractElement(JsonNode &node, char terminator)
 	return true;
 }
 
-bool JsonParser::extractFloat(JsonNode &node)
+bool JsonParser::extractFloat()
 {
 	assert(input[pos] == '-' || (input[pos] >= '0' && input[pos] <= '9'));
 	bool negative=false;
@@ -569,16 +658,14 @@ bool JsonParser::extractFloat(JsonNode &node)
 		if(negative)
 			result = -result;
 
-		node.setType(JsonNode::JsonType::DATA_FLOAT);
-		node.Float() = result;
+		handler->onFloat(result);
 	}
 	else
 	{
 		if(negative)
 			integerPart = -integerPart;
 
-		node.setType(JsonNode::JsonType::DATA_INTEGER);
-		node.Integer() = integerPart;
+		handler->onInteger(integerPart);
 	}
 
 	return true;
@@ -56,14 +56,66 @@ public:
 	}
 };
 
-//Internal class for string -> JsonNode conversion
-class JsonParser
+/// Receives content of json document from JsonParser as it is parsed, without building JsonNode tree.
+/// Every value is reported by one call, objects and arrays report their values between begin and end calls.
+/// Parsing stops on first syntax error, objects and arrays open at that point get no end call
+class DLL_LINKAGE IJsonEventHandler
+{
+public:
+	virtual ~IJsonEventHandler() = default;
+
+	virtual void onNull() = 0;
+	virtual void onBool(bool value) = 0;
+	virtual void onInteger(si64 value) = 0;
+	virtual void onFloat(double value) = 0;
+	/// string may be moved out by handler
+	virtual void onString(std::string & value) = 0;
+
+	virtual void onStructBegin() = 0;
+	/// key of next value in current object with meta-flags, returns false if this key was already present in object
+	virtual bool onStructKey(const std::string & key, const std::vector<std::string> & flags) = 0;
+	virtual void onStructEnd() = 0;
+
+	virtual void onArrayBegin() = 0;
+	virtual void onArrayEnd() = 0;
+};
+
+/// Builds JsonNode tree from parser events
+class DLL_LINKAGE JsonTreeBuilder : public IJsonEventHandler
+{
+public:
+	JsonNode root;
+
+	void onNull() override;
+	void onBool(bool value) override;
+	void onInteger(si64 value) override;
+	void onFloat(double value) override;
+	void onString(std::string & value) override;
+	void onStructBegin() override;
+	bool onStructKey(const std::string & key, const std::vector<std::string> & flags) override;
+	void onStructEnd() override;
+	void onArrayBegin() override;
+	void onArrayEnd() override;
+
+private:
+	/// objects and arrays being filled, innermost last
+	std::vector<JsonNode *> containers;
+	/// node of last key in innermost object
+	JsonNode * keyNode = nullptr;
+
+	/// node that receives next value
+	JsonNode & nextNode();
+};
+
+//Class for string -> JsonNode conversion
+class DLL_LINKAGE JsonParser
 {
 	std::string errors;     // Contains description of all encountered errors
 	constString input;      // Input data
 	ui32 lineCount; // Currently parsed line, starting from 1
 	size_t lineStart;       // Position of current line start
 	size_t pos;             // Current position of parser
+	IJsonEventHandler * handler; // Receiver of parsed data
 
 	//Helpers
 	bool extractEscaping(std::string &str);
@@ -71,17 +123,17 @@ class JsonParser
 	bool extractString(std::string &string);
 	bool extractWhitespace(bool verbose = true);
 	bool extractSeparator();
-	bool extractElement(JsonNode &node, char terminator);
+	bool extractElement(char terminator);
 
 	//Methods for extracting JSON data
-	bool extractArray(JsonNode &node);
-	bool extractFalse(JsonNode &node);
-	bool extractFloat(JsonNode &node);
-	bool extractNull(JsonNode &node);
-	bool extractString(JsonNode &node);
-	bool extractStruct(JsonNode &node);
-	bool extractTrue(JsonNode &node);
-	bool extractValue(JsonNode &node);
+	bool extractArray();
+	bool extractFalse();
+	bool extractFloat();
+	bool extractNull();
+	bool extractStringValue();
+	bool extractStruct();
+	bool extractTrue();
+	bool extractValue();
 
 	//Add error\warning message to list
 	bool error(const std::string &message, bool warning=false);
@@ -92,6 +144,9 @@ public:
 	/// do actual parsing. filename is name of file that will printed to console if any errors were found
 	JsonNode parse(std::string fileName);
 
+	/// same as above but passes data to handler as it is parsed instead of building tree
+	void parse(std::string fileName, IJsonEventHandler & eventHandler);
+
 	/// returns true if parsing was successful
 	bool isValid();
 };
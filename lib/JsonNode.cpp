@@ -28,6 +28,45 @@ class CModHandler;
 
 static const JsonNode nullNode;
 
+template<typename T>
+const T * JsonSharedValue<T>::intern(const T & value)
+{
+	if(value.empty())
+		return nullptr;
+
+	// consecutive nodes mostly have same value, so each thread checks the one it interned last before locking
+	static boost::thread_specific_ptr<const T *> lastValue;
+	if(!lastValue.get())
+		lastValue.reset(new const T *(nullptr));
+
+	const T * & last = *lastValue;
+	if(last && *last == value)
+		return last;
+
+	// files are parsed in parallel, set never moves its elements so returned pointers stay valid
+	static boost::mutex mx;
+	static std::set<T> values;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	last = &*values.insert(value).first;
+	return last;
+}
+
+template<typename T>
+const T & JsonSharedValue<T>::emptyValue()
+{
+	static const T empty;
+	return empty;
+}
+
+template class JsonSharedValue<std::string>;
+template class JsonSharedValue<std::vector<std::string>>;
+
+std::ostream & operator<<(std::ostream & out, const JsonSharedValue<std::string> & value)
+{
+	return out << value.get();
+}
+
 JsonNode::JsonNode(JsonType Type):
 	type(JsonType::DATA_NULL)
 {
@@ -87,6 +126,12 @@ JsonNode::JsonNode(const JsonNode &copy):
 	}
 }
 
+JsonNode::JsonNode(JsonNode && other) noexcept:
+	type(JsonType::DATA_NULL)
+{
+	swap(other);
+}
+
 JsonNode::~JsonNode()
 {
 	setType(JsonType::DATA_NULL);
@@ -137,24 +182,29 @@ JsonNode::JsonType JsonNode::getType() const
 
 void JsonNode::setMeta(std::string metadata, bool recursive)
 {
-	meta = metadata;
 	if (recursive)
+		setSharedMeta(metadata);
+	else
+		meta = metadata;
+}
+
+void JsonNode::setSharedMeta(const JsonSharedValue<std::string> & metadata)
+{
+	meta = metadata;
+	switch (type)
 	{
-		switch (type)
+		break; case JsonType::DATA_VECTOR:
 		{
-			break; case JsonType::DATA_VECTOR:
+			for(auto & node : Vector())
 			{
-				for(auto & node : Vector())
-				{
-					node.setMeta(metadata);
-				}
+				node.setSharedMeta(metadata);
 			}
-			break; case JsonType::DATA_STRUCT:
+		}
+		break; case JsonType::DATA_STRUCT:
+		{
+			for(auto & node : Struct())
 			{
-				for(auto & node : Struct())
-				{
-					node.second.setMeta(metadata);
-				}
+				node.second.setSharedMeta(metadata);
 			}
 		}
 	}
@@ -900,7 +950,10 @@ const JsonNode & getSchemaByName(std::string name)
 {
 	// cached schemas to avoid loading json data multiple times
 	static std::map<std::string, JsonNode> loadedSchemas;
+	// mods are validated in parallel, references stay valid since map never drops its nodes
+	static boost::mutex loadedSchemasMutex;
 
+	boost::unique_lock<boost::mutex> lock(loadedSchemasMutex);
 	if (vstd::contains(loadedSchemas, name))
 		return loadedSchemas[name];
 
@@ -969,7 +1022,7 @@ void JsonUtils::merge(JsonNode & dest, JsonNode & source, bool noOverride)
 		}
 		case JsonNode::JsonType::DATA_STRUCT:
 		{
-			if(!noOverride && vstd::contains(source.flags, "override"))
+			if(!noOverride && vstd::contains(source.flags.get(), "override"))
 			{
 				std::swap(dest, source);
 			}
@@ -18,6 +18,65 @@ class ResourceID;
 class CAddInfo;
 class ILimiter;
 
+/// Immutable value stored only once for all nodes that use it.
+/// All nodes of a file usually have same metadata, so each of them keeps only pointer to shared copy
+template<typename T>
+class DLL_LINKAGE JsonSharedValue
+{
+public:
+	JsonSharedValue()
+		: value(nullptr)
+	{
+	}
+
+	JsonSharedValue(const T & value)
+		: value(intern(value))
+	{
+	}
+
+	const T & get() const
+	{
+		return value ? *value : emptyValue();
+	}
+
+	operator const T &() const
+	{
+		return get();
+	}
+
+	bool empty() const
+	{
+		return value == nullptr;
+	}
+
+	bool operator==(const JsonSharedValue & other) const
+	{
+		return value == other.value;
+	}
+
+	bool operator!=(const JsonSharedValue & other) const
+	{
+		return value != other.value;
+	}
+
+	template <typename Handler> void serialize(Handler & h, const int version)
+	{
+		T copy = get();
+		h & copy;
+		if(!h.saving)
+			value = intern(copy);
+	}
+
+private:
+	/// nullptr for empty value, so default-constructed nodes never touch shared storage
+	const T * value;
+
+	static const T * intern(const T & value);
+	static const T & emptyValue();
+};
+
+DLL_LINKAGE std::ostream & operator<<(std::ostream & out, const JsonSharedValue<std::string> & value);
+
 class DLL_LINKAGE JsonNode
 {
 public:
@@ -46,11 +105,13 @@ private:
 	JsonType type;
 	JsonData data;
 
+	void setSharedMeta(const JsonSharedValue<std::string> & metadata);
+
 public:
 	/// free to use metadata fields
-	std::string meta;
+	JsonSharedValue<std::string> meta;
 	// meta-flags like override
-	std::vector<std::string> flags;
+	JsonSharedValue<std::vector<std::string>> flags;
 
 	//Create empty node
 	JsonNode(JsonType Type = JsonType::DATA_NULL);
@@ -62,6 +123,7 @@ public:
 	explicit JsonNode(ResourceID && fileURI, bool & isValidSyntax);
 	//Copy c-tor
 	JsonNode(const JsonNode &copy);
+	JsonNode(JsonNode && other) noexcept;
 
 	~JsonNode();
 
@@ -388,9 +388,9 @@ PlayerColor CBattleInfoEssentials::battleGetOwner(const battle::Unit * unit) con
 	PlayerColor initialOwner = getBattle()->getSidePlayer(unit->unitSide());
 
 	static CSelector selector = Selector::type(Bonus::HYPNOTIZED);
-	static std::string cachingString = "type_103s-1";
+	static const auto cachingKey = BonusCacheKey::type(Bonus::HYPNOTIZED);
 
-	if(unit->hasBonus(selector, cachingString))
+	if(unit->hasBonus(selector, cachingKey))
 		return otherPlayer(initialOwner);
 	else
 		return initialOwner;
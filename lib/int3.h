@@ -21,16 +21,10 @@ public:
 	explicit int3(const si32 i) : x(i), y(i), z(i) {}
 	//c-tor: x, y, z initialized to X, Y, Z
 	int3(const si32 X, const si32 Y, const si32 Z) : x(X), y(Y), z(Z) {}
-	int3(const int3 & c) : x(c.x), y(c.y), z(c.z) {} // Should be set to default (C++11)?
+	//defaulted, so that int3 stays trivially copyable
+	int3(const int3 & c) = default;
+	int3 & operator=(const int3 & c) = default;
 
-	int3 & operator=(const int3 & c) // Should be set to default (C++11)?
-	{
-		x = c.x;
-		y = c.y;
-		z = c.z;
-
-		return *this;
-	}
 	int3 operator-() const { return int3(-x, -y, -z); }
 
 	int3 operator+(const int3 & i) const { return int3(x + i.x, y + i.y, z + i.z); }
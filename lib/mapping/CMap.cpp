@@ -123,6 +123,53 @@ CCastleEvent::CCastleEvent() : town(nullptr)
 
 }
 
+static const TileObjects::TList noTileObjects; //begin and end of empty list must come from same container
+
+TileObjects::TileObjects(const TileObjects & other)
+	: objects(other.objects ? make_unique<TList>(*other.objects) : nullptr)
+{
+
+}
+
+TileObjects & TileObjects::operator=(const TileObjects & other)
+{
+	if(this != &other)
+		objects = other.objects ? make_unique<TList>(*other.objects) : nullptr;
+	return *this;
+}
+
+TileObjects::const_iterator TileObjects::begin() const
+{
+	return objects ? objects->begin() : noTileObjects.begin();
+}
+
+TileObjects::const_iterator TileObjects::end() const
+{
+	return objects ? objects->end() : noTileObjects.end();
+}
+
+void TileObjects::push_back(CGObjectInstance * obj)
+{
+	if(!objects)
+		objects = make_unique<TList>();
+	objects->push_back(obj);
+}
+
+bool TileObjects::remove(const CGObjectInstance * obj)
+{
+	if(!objects)
+		return false;
+
+	auto it = std::find(objects->begin(), objects->end(), obj);
+	if(it == objects->end())
+		return false;
+
+	objects->erase(it);
+	if(objects->empty())
+		objects.reset();
+	return true;
+}
+
 TerrainTile::TerrainTile() : terType(ETerrainType::BORDER), terView(0), riverType(ERiverType::NO_RIVER),
 	riverDir(0), roadType(ERoadType::NO_ROAD), roadDir(0), extTileFlags(0), visitable(false),
 	blocked(false)
@@ -232,8 +279,7 @@ CMapHeader::~CMapHeader()
 }
 
 CMap::CMap()
-	: checksum(0), grailPos(-1, -1, -1), grailRadius(0), terrain(nullptr),
-	guardingCreaturePositions(nullptr)
+	: checksum(0), grailPos(-1, -1, -1), grailRadius(0)
 {
 	allHeroes.resize(allowedHeroes.size());
 	allowedAbilities = VLC->skillh->getDefaultAllowed();
@@ -243,22 +289,6 @@ CMap::CMap()
 
 CMap::~CMap()
 {
-	if(terrain)
-	{
-		for (int i=0; i<width; i++)
-		{
-			for(int j=0; j<height; j++)
-			{
-				delete [] terrain[i][j];
-				delete [] guardingCreaturePositions[i][j];
-			}
-			delete [] terrain[i];
-			delete [] guardingCreaturePositions[i];
-		}
-		delete [] terrain;
-		delete [] guardingCreaturePositions;
-	}
-
 	for(auto obj : objects)
 		obj.dellNull();
 
@@ -279,15 +309,15 @@ void CMap::removeBlockVisTiles(CGObjectInstance * obj, bool total)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
 				if(total || obj->visitableAt(xVal, yVal))
 				{
-					curt.visitableObjects -= obj;
+					curt.visitableObjects.remove(obj);
 					curt.visitable = curt.visitableObjects.size();
 				}
 				if(total || obj->blockingAt(xVal, yVal))
 				{
-					curt.blockingObjects -= obj;
+					curt.blockingObjects.remove(obj);
 					curt.blocked = curt.blockingObjects.size();
 				}
 			}
@@ -306,7 +336,7 @@ void CMap::addBlockVisTiles(CGObjectInstance * obj)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
 				if( obj->visitableAt(xVal, yVal))
 				{
 					curt.visitableObjects.push_back(obj);
@@ -325,12 +355,12 @@ void CMap::addBlockVisTiles(CGObjectInstance * obj)
 void CMap::calculateGuardingGreaturePositions()
 {
 	int levels = twoLevel ? 2 : 1;
-	for (int i=0; i<width; i++)
+	for(int k = 0; k < levels; k++)
 	{
-		for(int j=0; j<height; j++)
+		for(int j = 0; j < height; j++)
 		{
-			for (int k = 0; k < levels; k++)
-				guardingCreaturePositions[i][j][k] = guardingCreaturePosition(int3(i,j,k));
+			for(int i = 0; i < width; i++)
+				guardingCreaturePositions[tileIndex(int3(i, j, k))] = guardingCreaturePosition(int3(i, j, k));
 		}
 	}
 }
@@ -388,13 +418,19 @@ bool CMap::isInTheMap(const int3 & pos) const
 TerrainTile & CMap::getTile(const int3 & tile)
 {
 	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
+	return terrain[tileIndex(tile)];
 }
 
 const TerrainTile & CMap::getTile(const int3 & tile) const
 {
 	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
+	return terrain[tileIndex(tile)];
+}
+
+const int3 & CMap::getGuardingCreaturePosition(const int3 & tile) const
+{
+	assert(isInTheMap(tile));
+	return guardingCreaturePositions[tileIndex(tile)];
 }
 
 bool CMap::isWaterTile(const int3 &pos) const
@@ -624,19 +660,9 @@ void CMap::addNewObject(CGObjectInstance * obj)
 
 void CMap::initTerrain()
 {
-	int level = twoLevel ? 2 : 1;
-	terrain = new TerrainTile**[width];
-	guardingCreaturePositions = new int3**[width];
-	for (int i = 0; i < width; ++i)
-	{
-		terrain[i] = new TerrainTile*[height];
-		guardingCreaturePositions[i] = new int3*[height];
-		for (int j = 0; j < height; ++j)
-		{
-			terrain[i][j] = new TerrainTile[level];
-			guardingCreaturePositions[i][j] = new int3[level];
-		}
-	}
+	const size_t tilesCount = width * height * (twoLevel ? 2 : 1);
+	terrain.assign(tilesCount, TerrainTile());
+	guardingCreaturePositions.assign(tilesCount, int3());
 }
 
 CMapEditManager * CMap::getEditManager()
@@ -363,6 +363,8 @@ public:
 	bool canMoveBetween(const int3 &src, const int3 &dst) const;
 	bool checkForVisitableDir( const int3 & src, const TerrainTile *pom, const int3 & dst ) const;
 	int3 guardingCreaturePosition (int3 pos) const;
+	/// Result of guardingCreaturePosition cached by calculateGuardingGreaturePositions
+	const int3 & getGuardingCreaturePosition(const int3 & tile) const;
 
 	void addBlockVisTiles(CGObjectInstance * obj);
 	void removeBlockVisTiles(CGObjectInstance * obj, bool total = false);
@@ -412,13 +414,17 @@ public:
 
 	std::unique_ptr<CMapEditManager> editManager;
 
-	int3 ***guardingCreaturePositions;
-
 	std::map<std::string, ConstTransitivePtr<CGObjectInstance> > instanceNames;
 
 private:
-	/// a 3-dimensional array of terrain tiles, access is as follows: x, y, level. where level=1 is underground
-	TerrainTile*** terrain;
+	/// tiles of all levels in one block, row after row, level 1 (underground) follows level 0
+	std::vector<TerrainTile> terrain;
+	std::vector<int3> guardingCreaturePositions; //same layout as terrain
+
+	size_t tileIndex(const int3 & tile) const
+	{
+		return (static_cast<size_t>(tile.z) * height + tile.y) * width + tile.x;
+	}
 
 public:
 	template <typename Handler>
@@ -438,45 +444,19 @@ public:
 
 		//TODO: viccondetails
 		int level = twoLevel ? 2 : 1;
-		if(h.saving)
-		{
-			// Save terrain
-			for(int i = 0; i < width ; ++i)
-			{
-				for(int j = 0; j < height ; ++j)
-				{
-					for(int k = 0; k < level; ++k)
-					{
-						h & terrain[i][j][k];
-						h & guardingCreaturePositions[i][j][k];
-					}
-				}
-			}
-		}
-		else
+		if(!h.saving)
+			initTerrain();
+
+		// Terrain is stored column by column as it used to be kept in memory
+		for(int i = 0; i < width ; ++i)
 		{
-			// Load terrain
-			terrain = new TerrainTile**[width];
-			guardingCreaturePositions = new int3**[width];
-			for(int i = 0; i < width; ++i)
-			{
-				terrain[i] = new TerrainTile*[height];
-				guardingCreaturePositions[i] = new int3*[height];
-				for(int j = 0; j < height; ++j)
-				{
-					terrain[i][j] = new TerrainTile[level];
-					guardingCreaturePositions[i][j] = new int3[level];
-				}
-			}
-			for(int i = 0; i < width ; ++i)
+			for(int j = 0; j < height ; ++j)
 			{
-				for(int j = 0; j < height ; ++j)
+				for(int k = 0; k < level; ++k)
 				{
-					for(int k = 0; k < level; ++k)
-					{
-						h & terrain[i][j][k];
-						h & guardingCreaturePositions[i][j][k];
-					}
+					const size_t index = tileIndex(int3(i, j, k));
+					h & terrain[index];
+					h & guardingCreaturePositions[index];
 				}
 			}
 		}
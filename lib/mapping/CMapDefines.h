@@ -62,6 +62,55 @@ public:
 	}
 };
 
+/// Objects residing on one tile, in order they were put there.
+/// Most tiles hold no objects, so the list lives outside of the tile and costs one pointer while empty.
+class DLL_LINKAGE TileObjects
+{
+public:
+	typedef std::vector<CGObjectInstance *> TList;
+	typedef TList::const_iterator const_iterator;
+
+	TileObjects() = default;
+	TileObjects(const TileObjects & other);
+	TileObjects(TileObjects && other) = default;
+	TileObjects & operator=(const TileObjects & other);
+	TileObjects & operator=(TileObjects && other) = default;
+
+	bool empty() const { return !objects; }
+	size_t size() const { return objects ? objects->size() : 0; }
+
+	CGObjectInstance * front() const { return objects->front(); }
+	CGObjectInstance * back() const { return objects->back(); }
+	CGObjectInstance * operator[](size_t index) const { return (*objects)[index]; }
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	void push_back(CGObjectInstance * obj);
+	/// Removes first occurrence of object, returns false if there was none
+	bool remove(const CGObjectInstance * obj);
+
+	template <typename Handler>
+	void serialize(Handler & h, const int version)
+	{
+		//same format as plain vector
+		if(h.saving)
+		{
+			TList list = objects ? *objects : TList();
+			h & list;
+		}
+		else
+		{
+			TList list;
+			h & list;
+			objects = list.empty() ? nullptr : make_unique<TList>(std::move(list));
+		}
+	}
+
+private:
+	std::unique_ptr<TList> objects; //null if there are no objects
+};
+
 /// The terrain tile describes the terrain type and the visual representation of the terrain.
 /// Furthermore the struct defines whether the tile is visitable or/and blocked and which objects reside in it.
 struct DLL_LINKAGE TerrainTile
@@ -92,8 +141,8 @@ struct DLL_LINKAGE TerrainTile
 	bool visitable;
 	bool blocked;
 
-	std::vector<CGObjectInstance *> visitableObjects;
-	std::vector<CGObjectInstance *> blockingObjects;
+	TileObjects visitableObjects;
+	TileObjects blockingObjects;
 
 	template <typename Handler>
 	void serialize(Handler & h, const int version)
@@ -883,7 +883,7 @@ std::unique_ptr<CMapHeader> CMapLoaderJson::loadMapHeader()
 	return std::move(result);
 }
 
-JsonNode CMapLoaderJson::getFromArchive(const std::string & archiveFilename)
+void CMapLoaderJson::parseFromArchive(const std::string & archiveFilename, IJsonEventHandler & handler)
 {
 	ResourceID resource(archiveFilename, EResType::TEXT);
 
@@ -892,9 +892,15 @@ JsonNode CMapLoaderJson::getFromArchive(const std::string & archiveFilename)
 
 	auto data = loader.load(resource)->readAll();
 
-	JsonNode res(reinterpret_cast<char*>(data.first.get()), data.second);
+	JsonParser parser(reinterpret_cast<char*>(data.first.get()), data.second);
+	parser.parse(archiveFilename, handler);
+}
 
-	return std::move(res);
+JsonNode CMapLoaderJson::getFromArchive(const std::string & archiveFilename)
+{
+	JsonTreeBuilder builder;
+	parseFromArchive(archiveFilename, builder);
+	return std::move(builder.root);
 }
 
 void CMapLoaderJson::readMap()
@@ -1062,39 +1068,95 @@ void CMapLoaderJson::readTerrainTile(const std::string & src, TerrainTile & tile
 	}
 }
 
-void CMapLoaderJson::readTerrainLevel(const JsonNode & src, const int index)
+///Terrain level is array of rows, each row is array of tile codes. Tiles are decoded as soon as they are parsed
+class CMapLoaderJson::TerrainLevelReader : public IJsonEventHandler
 {
-	int3 pos(0, 0, index);
+public:
+	TerrainLevelReader(CMap * map, const int index):
+		map(map),
+		pos(0, 0, index),
+		depth(0),
+		finished(false)
+	{
+	}
 
-	const JsonVector & rows = src.Vector();
+	void onNull() override { invalid(); }
+	void onBool(bool value) override { invalid(); }
+	void onInteger(si64 value) override { invalid(); }
+	void onFloat(double value) override { invalid(); }
+	void onStructBegin() override { invalid(); }
+	bool onStructKey(const std::string & key, const std::vector<std::string> & flags) override { invalid(); return false; }
+	void onStructEnd() override { invalid(); }
 
-	if(rows.size() != map->height)
-		throw new std::runtime_error("Invalid terrain data");
+	void onString(std::string & value) override
+	{
+		if(depth != 2 || pos.x >= map->width)
+			invalid();
 
-	for(pos.y = 0; pos.y < map->height; pos.y++)
+		readTerrainTile(value, map->getTile(pos));
+		pos.x++;
+	}
+
+	void onArrayBegin() override
 	{
-		const JsonVector & tiles = rows[pos.y].Vector();
+		if(finished || depth == 2 || (depth == 1 && pos.y >= map->height))
+			invalid();
 
-		if(tiles.size() != map->width)
-			throw new std::runtime_error("Invalid terrain data");
+		depth++;
+		pos.x = 0;
+	}
 
-		for(pos.x = 0; pos.x < map->width; pos.x++)
-			readTerrainTile(tiles[pos.x].String(), map->getTile(pos));
+	void onArrayEnd() override
+	{
+		if(depth == 2)
+		{
+			if(pos.x != map->width)
+				invalid();
+			pos.y++;
+		}
+		else
+		{
+			if(pos.y != map->height)
+				invalid();
+			finished = true;
+		}
+		depth--;
 	}
-}
 
-void CMapLoaderJson::readTerrain()
-{
+	/// true if whole level was read
+	bool isFinished() const
 	{
-		const JsonNode surface = getFromArchive("surface_terrain.json");
-		readTerrainLevel(surface, 0);
+		return finished;
 	}
-	if(map->twoLevel)
+
+private:
+	CMap * map;
+	int3 pos;
+	///0 - outside of level, 1 - inside of level, 2 - inside of row
+	int depth;
+	bool finished;
+
+	void invalid()
 	{
-		const JsonNode underground = getFromArchive("underground_terrain.json");
-		readTerrainLevel(underground, 1);
+		throw std::runtime_error("Invalid terrain data");
 	}
+};
+
+void CMapLoaderJson::readTerrainLevel(const std::string & archiveFilename, const int index)
+{
+	TerrainLevelReader reader(map, index);
+	parseFromArchive(archiveFilename, reader);
+
+	if(!reader.isFinished())
+		throw std::runtime_error("Invalid terrain data");
+}
 
+void CMapLoaderJson::readTerrain()
+{
+	readTerrainLevel("surface_terrain.json", 0);
+
+	if(map->twoLevel)
+		readTerrainLevel("underground_terrain.json", 1);
 }
 
 CMapLoaderJson::MapObjectLoader::MapObjectLoader(CMapLoaderJson * _owner, JsonMap::value_type & json):
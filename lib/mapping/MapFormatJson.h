@@ -28,6 +28,7 @@ class AObjectTypeHandler;
 class JsonSerializeFormat;
 class JsonDeserializer;
 class JsonSerializer;
+class IJsonEventHandler;
 
 class DLL_LINKAGE CMapFormatJson
 {
@@ -193,7 +194,10 @@ public:
 
 	static void readTerrainTile(const std::string & src, TerrainTile & tile);
 
-	void readTerrainLevel(const JsonNode & src, const int index);
+	/**
+	 * Reads one level of terrain directly from parser events, without building json tree
+	 */
+	void readTerrainLevel(const std::string & archiveFilename, const int index);
 
 	void readTerrain();
 
@@ -204,7 +208,11 @@ public:
 
 	JsonNode getFromArchive(const std::string & archiveFilename);
 
+	void parseFromArchive(const std::string & archiveFilename, IJsonEventHandler & handler);
+
 private:
+	class TerrainLevelReader;
+
 	CInputStream * buffer;
 	std::shared_ptr<CIOApi> ioApi;
 
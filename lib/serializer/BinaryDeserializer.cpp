@@ -10,13 +10,21 @@
 #include "StdInc.h"
 #include "BinaryDeserializer.h"
 #include "../filesystem/FileStream.h"
+#include "BinarySerializer.h"
+
+#include <zlib.h>
 
 #include "../registerTypes/RegisterTypes.h"
 
 extern template void registerTypes<BinaryDeserializer>(BinaryDeserializer & s);
 
+namespace
+{
+	const size_t COMPRESSION_CHUNK_SIZE = 64 * 1024;
+}
+
 CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
-	: serializer(this)
+	: serializer(this), compressedRemaining(0)
 {
 	registerTypes(serializer);
 	openNextFile(fname, minimalVersion);
@@ -24,11 +32,39 @@ CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
 
 CLoadFile::~CLoadFile()
 {
+	endDecompression();
 }
 
 int CLoadFile::read(void * data, unsigned size)
 {
-	sfile->read((char*)data,size);
+	if(!inflateStream)
+	{
+		sfile->read((char*)data,size);
+		return size;
+	}
+
+	inflateStream->next_out = static_cast<Bytef *>(data);
+	inflateStream->avail_out = size;
+	while(inflateStream->avail_out > 0)
+	{
+		if(inflateStream->avail_in == 0)
+		{
+			const si64 chunkSize = std::min<si64>(compressedRemaining, compressedData.size());
+			if(chunkSize == 0)
+				THROW_FORMAT("Error: unexpected end of file %s!", fName);
+
+			sfile->read(reinterpret_cast<char *>(compressedData.data()), chunkSize);
+			compressedRemaining -= chunkSize;
+			inflateStream->next_in = compressedData.data();
+			inflateStream->avail_in = static_cast<uInt>(chunkSize);
+		}
+
+		const int result = inflate(inflateStream.get(), Z_NO_FLUSH);
+		if(result == Z_STREAM_END && inflateStream->avail_out > 0)
+			THROW_FORMAT("Error: unexpected end of file %s!", fName);
+		if(result != Z_OK && result != Z_STREAM_END)
+			THROW_FORMAT("Error: corrupted file %s!", fName);
+	}
 	return size;
 }
 
@@ -37,6 +73,10 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 	assert(!serializer.reverseEndianess);
 	assert(minimalVersion <= SERIALIZATION_VERSION);
 
+	//file may be still written by CSaveBuffer of this process
+	CSaveBuffer::waitForBackgroundWrites();
+	endDecompression();
+
 	try
 	{
 		fName = fname.string();
@@ -49,7 +89,8 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 		//we can read
 		char buffer[4];
 		sfile->read(buffer, 4);
-		if(std::memcmp(buffer,"VCMI",4))
+		const bool compressed = !std::memcmp(buffer,"VCMZ",4);
+		if(!compressed && std::memcmp(buffer,"VCMI",4))
 			THROW_FORMAT("Error: not a VCMI file(%s)!", fName);
 
 		serializer & serializer.fileVersion;
@@ -72,6 +113,19 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 			else
 				THROW_FORMAT("Error: too new file format (%s)!", fName);
 		}
+
+		//rest of compressed file is single zlib stream
+		if(compressed)
+		{
+			inflateStream = make_unique<z_stream>();
+			if(inflateInit(inflateStream.get()) != Z_OK)
+			{
+				inflateStream.reset();
+				THROW_FORMAT("Error: cannot decompress %s!", fName);
+			}
+			compressedData.resize(COMPRESSION_CHUNK_SIZE);
+			compressedRemaining = boost::filesystem::file_size(fname) - sfile->tellg();
+		}
 	}
 	catch(...)
 	{
@@ -89,6 +143,7 @@ void CLoadFile::reportState(vstd::CLoggerBase * out)
 
 void CLoadFile::clear()
 {
+	endDecompression();
 	sfile = nullptr;
 	fName.clear();
 	serializer.fileVersion = 0;
@@ -101,3 +156,13 @@ void CLoadFile::checkMagicBytes(const std::string &text)
 	if(loaded != text)
 		throw std::runtime_error("Magic bytes doesn't match!");
 }
+
+void CLoadFile::endDecompression()
+{
+	if(inflateStream)
+	{
+		inflateEnd(inflateStream.get());
+		inflateStream.reset();
+	}
+	compressedRemaining = 0;
+}
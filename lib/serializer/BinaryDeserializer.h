@@ -12,11 +12,13 @@
 #include <boost/mpl/for_each.hpp>
 
 #include "CTypeList.h"
+#include "LoadProfiler.h"
 #include "../mapObjects/CGHeroInstance.h"
 #include "../../Global.h"
 
 class CStackInstance;
 class FileStream;
+struct z_stream_s;
 
 class DLL_LINKAGE CLoaderBase
 {
@@ -152,6 +154,7 @@ class DLL_LINKAGE BinaryDeserializer : public CLoaderBase
 			s.ptrAllocated(ptr, pid);
 			//T is most derived known type, it's time to call actual serialize
 			assert(s.fileVersion != 0);
+			LoadProfilerSection section(typeid(T).name());
 			ptr->serialize(s,s.fileVersion);
 			return &typeid(T);
 		}
@@ -165,9 +168,15 @@ public:
 	bool reverseEndianess; //if source has different endianness than us, we reverse bytes
 	si32 fileVersion;
 
-	std::map<ui32, void*> loadedPointers;
-	std::map<ui32, const std::type_info*> loadedPointersTypes;
-	std::map<const void*, boost::any> loadedSharedPointers;
+	struct LoadedPointer
+	{
+		void * ptr;
+		const std::type_info * type; //most derived type of object
+	};
+
+	/// Indexed by pointer id. Ids are given out sequentially while saving, so vector is dense; unused ids have nullptr
+	std::vector<LoadedPointer> loadedPointers;
+	std::unordered_map<const void*, boost::any> loadedSharedPointers;
 	bool smartPointerSerialization;
 	bool saving;
 
@@ -238,7 +247,7 @@ public:
 		range::copy(convData, data.begin());
 	}
 
-	template <typename T, typename std::enable_if < !std::is_same<T, bool >::value, int  >::type = 0>
+	template <typename T, typename std::enable_if < !std::is_same<T, bool >::value && !is_bulk_serializeable<T>::value, int  >::type = 0>
 	void load(std::vector<T> &data)
 	{
 		ui32 length = readAndCheckLength();
@@ -247,6 +256,25 @@ public:
 			load( data[i]);
 	}
 
+	template <typename T, typename std::enable_if < is_bulk_serializeable<T>::value, int  >::type = 0>
+	void load(std::vector<T> &data)
+	{
+		ui32 length = readAndCheckLength();
+		data.resize(length);
+		if(!length)
+			return;
+
+		char * dataPtr = reinterpret_cast<char *>(data.data());
+		const size_t size = length * sizeof(T);
+		this->read(dataPtr, size);
+		if(reverseEndianess)
+		{
+			const size_t fieldSize = sizeof(typename is_bulk_serializeable<T>::FieldType);
+			for(size_t field = 0; field < size; field += fieldSize)
+				std::reverse(dataPtr + field, dataPtr + field + fieldSize);
+		}
+	}
+
 	template < typename T, typename std::enable_if < std::is_pointer<T>::value, int  >::type = 0 >
 	void load(T &data)
 	{
@@ -286,14 +314,13 @@ public:
 		if(smartPointerSerialization)
 		{
 			load( pid ); //get the id
-			std::map<ui32, void*>::iterator i = loadedPointers.find(pid); //lookup
 
-			if(i != loadedPointers.end())
+			if(pid < loadedPointers.size() && loadedPointers[pid].ptr)
 			{
 				// We already got this pointer
 				// Cast it in case we are loading it to a non-first base pointer
-				assert(loadedPointersTypes.count(pid));
-				data = reinterpret_cast<T>(typeList.castRaw(i->second, loadedPointersTypes.at(pid), &typeid(typename std::remove_const<typename std::remove_pointer<T>::type>::type)));
+				const LoadedPointer & loaded = loadedPointers[pid];
+				data = reinterpret_cast<T>(typeList.castRaw(loaded.ptr, loaded.type, &typeid(typename std::remove_const<typename std::remove_pointer<T>::type>::type)));
 				return;
 			}
 		}
@@ -308,6 +335,7 @@ public:
 			typedef typename std::remove_const<npT>::type ncpT;
 			data = ClassObjectCreator<ncpT>::invoke();
 			ptrAllocated(data, pid);
+			LoadProfilerSection section(typeid(ncpT).name());
 			load(*data);
 		}
 		else
@@ -329,8 +357,14 @@ public:
 	{
 		if(smartPointerSerialization && pid != 0xffffffff)
 		{
-			loadedPointersTypes[pid] = &typeid(T);
-			loadedPointers[pid] = (void*)ptr; //add loaded pointer to our lookup map; cast is to avoid errors with const T* pt
+			if(pid >= loadedPointers.size())
+			{
+				//only few ids may be skipped, large gap means corrupted data
+				if(pid - loadedPointers.size() > 100000)
+					throw std::runtime_error("Invalid pointer id " + std::to_string(pid));
+				loadedPointers.resize(pid + 1, LoadedPointer{nullptr, nullptr});
+			}
+			loadedPointers[pid] = LoadedPointer{(void*)ptr, &typeid(T)}; //cast is to avoid errors with const T* pt
 		}
 	}
 
@@ -520,6 +554,7 @@ public:
 	std::string fName;
 	std::unique_ptr<FileStream> sfile;
 
+	/// reads both plain and compressed files written by CSaveFile
 	CLoadFile(const boost::filesystem::path & fname, int minimalVersion = SERIALIZATION_VERSION); //throws!
 	~CLoadFile();
 	int read(void * data, unsigned size) override; //throws!
@@ -536,4 +571,12 @@ public:
 		serializer & t;
 		return * this;
 	}
+
+private:
+	std::unique_ptr<z_stream_s> inflateStream;
+	std::vector<ui8> compressedData;
+	/// compressed bytes of file not read yet
+	si64 compressedRemaining;
+
+	void endDecompression();
 };
@@ -10,30 +10,98 @@
 #include "StdInc.h"
 #include "BinarySerializer.h"
 #include "../filesystem/FileStream.h"
+#include "../CStopWatch.h"
+#include "../CThreadHelper.h"
+
+#include <zlib.h>
 
 #include "../registerTypes/RegisterTypes.h"
 
 extern template void registerTypes<BinarySerializer>(BinarySerializer & s);
 
-CSaveFile::CSaveFile(const boost::filesystem::path &fname)
+namespace
+{
+	const size_t COMPRESSION_CHUNK_SIZE = 64 * 1024;
+
+	/// Thread of last CSaveBuffer write. Writes run one at a time, so older save never replaces newer one
+	class BackgroundWrites
+	{
+	public:
+		~BackgroundWrites()
+		{
+			wait();
+		}
+
+		void start(const std::function<void()> & task)
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			if(thread)
+				thread->join();
+			thread = make_unique<boost::thread>(task);
+		}
+
+		void wait()
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			if(thread)
+			{
+				thread->join();
+				thread.reset();
+			}
+		}
+
+	private:
+		boost::mutex mx;
+		std::unique_ptr<boost::thread> thread;
+	};
+
+	BackgroundWrites & backgroundWrites()
+	{
+		static BackgroundWrites writes;
+		return writes;
+	}
+}
+
+CSaveFile::CSaveFile(const boost::filesystem::path &fname, bool compressed)
 	: serializer(this)
 {
 	registerTypes(serializer);
-	openNextFile(fname);
+	openNextFile(fname, compressed);
 }
 
 CSaveFile::~CSaveFile()
 {
+	try
+	{
+		clear();
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to finish writing %s: %s", fName.string(), e.what());
+	}
 }
 
 int CSaveFile::write(const void * data, unsigned size)
 {
-	sfile->write((char *)data,size);
+	if(deflateStream)
+	{
+		const ui8 * bytes = static_cast<const ui8 *>(data);
+		pendingData.insert(pendingData.end(), bytes, bytes + size);
+		if(pendingData.size() >= COMPRESSION_CHUNK_SIZE)
+			compressPending(Z_NO_FLUSH);
+	}
+	else
+	{
+		sfile->write((char *)data,size);
+	}
 	return size;
 }
 
-void CSaveFile::openNextFile(const boost::filesystem::path &fname)
+void CSaveFile::openNextFile(const boost::filesystem::path &fname, bool compressed)
 {
+	if(deflateStream)
+		finishCompression();
+
 	fName = fname;
 	try
 	{
@@ -43,17 +111,71 @@ void CSaveFile::openNextFile(const boost::filesystem::path &fname)
 		if(!(*sfile))
 			THROW_FORMAT("Error: cannot open to write %s!", fname);
 
-		sfile->write("VCMI",4); //write magic identifier
+		sfile->write(compressed ? "VCMZ" : "VCMI", 4); //write magic identifier
 		serializer & SERIALIZATION_VERSION; //write format version
+
+		if(compressed)
+		{
+			deflateStream = make_unique<z_stream>();
+			if(deflateInit(deflateStream.get(), Z_BEST_SPEED) != Z_OK)
+			{
+				deflateStream.reset();
+				THROW_FORMAT("Error: cannot compress %s!", fname);
+			}
+			compressedData.resize(COMPRESSION_CHUNK_SIZE);
+		}
 	}
 	catch(...)
 	{
 		logGlobal->error("Failed to save to %s", fname.string());
+		endCompression();
 		clear();
 		throw;
 	}
 }
 
+void CSaveFile::compressPending(int flush)
+{
+	deflateStream->next_in = pendingData.data();
+	deflateStream->avail_in = static_cast<uInt>(pendingData.size());
+	do
+	{
+		deflateStream->next_out = compressedData.data();
+		deflateStream->avail_out = static_cast<uInt>(compressedData.size());
+		if(deflate(deflateStream.get(), flush) == Z_STREAM_ERROR)
+			THROW_FORMAT("Error: failed to compress %s!", fName);
+
+		sfile->write(reinterpret_cast<const char *>(compressedData.data()), compressedData.size() - deflateStream->avail_out);
+	}
+	while(deflateStream->avail_out == 0);
+
+	pendingData.clear();
+}
+
+void CSaveFile::finishCompression()
+{
+	try
+	{
+		compressPending(Z_FINISH);
+	}
+	catch(...)
+	{
+		endCompression();
+		throw;
+	}
+	endCompression();
+}
+
+void CSaveFile::endCompression()
+{
+	if(deflateStream)
+	{
+		deflateEnd(deflateStream.get());
+		deflateStream.reset();
+	}
+	pendingData.clear();
+}
+
 void CSaveFile::reportState(vstd::CLoggerBase * out)
 {
 	out->debug("CSaveFile");
@@ -65,6 +187,9 @@ void CSaveFile::reportState(vstd::CLoggerBase * out)
 
 void CSaveFile::clear()
 {
+	if(deflateStream)
+		finishCompression();
+
 	fName.clear();
 	sfile = nullptr;
 }
@@ -73,3 +198,63 @@ void CSaveFile::putMagicBytes(const std::string &text)
 {
 	write(text.c_str(), text.length());
 }
+
+CSaveBuffer::CSaveBuffer()
+	: serializer(this)
+{
+	registerTypes(serializer);
+}
+
+int CSaveBuffer::write(const void * data, unsigned size)
+{
+	const ui8 * bytes = static_cast<const ui8 *>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+	return size;
+}
+
+void CSaveBuffer::putMagicBytes(const std::string &text)
+{
+	write(text.c_str(), text.length());
+}
+
+size_t CSaveBuffer::getSize() const
+{
+	return buffer.size();
+}
+
+void CSaveBuffer::writeInBackground(const boost::filesystem::path & fname, bool compressed)
+{
+	auto data = std::make_shared<std::vector<ui8>>();
+	data->swap(buffer);
+
+	backgroundWrites().start([data, fname, compressed]()
+	{
+		setThreadName("CSaveBuffer::writeInBackground");
+		CStopWatch timer;
+
+		boost::filesystem::path tempName = fname;
+		tempName += ".tmp";
+		try
+		{
+			si64 fileSize;
+			{
+				CSaveFile file(tempName, compressed);
+				file.write(data->data(), static_cast<unsigned>(data->size()));
+				file.clear();
+				fileSize = boost::filesystem::file_size(tempName);
+			}
+			boost::filesystem::rename(tempName, fname);
+
+			logGlobal->info("Written %s in background: %d KB of data, file size %d KB, %d ms", fname.string(), data->size() / 1024, fileSize / 1024, timer.getDiff());
+		}
+		catch(std::exception & e)
+		{
+			logGlobal->error("Failed to write %s: %s", fname.string(), e.what());
+		}
+	});
+}
+
+void CSaveBuffer::waitForBackgroundWrites()
+{
+	backgroundWrites().wait();
+}
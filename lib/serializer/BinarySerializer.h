@@ -13,6 +13,7 @@
 #include "../mapObjects/CArmedInstance.h"
 
 class FileStream;
+struct z_stream_s;
 
 class DLL_LINKAGE CSaverBase
 {
@@ -109,7 +110,7 @@ class DLL_LINKAGE BinarySerializer : public CSaverBase
 	CApplier<CBasicPointerSaver> applier;
 
 public:
-	std::map<const void*, ui32> savedPointers;
+	std::unordered_map<const void*, ui32> savedPointers;
 
 	bool smartPointerSerialization;
 	bool saving;
@@ -208,7 +209,7 @@ public:
 			// We might have an object that has multiple inheritance and store it via the non-first base pointer.
 			// Therefore, all pointers need to be normalized to the actual object address.
 			auto actualPointer = typeList.castToMostDerived(data);
-			std::map<const void*,ui32>::iterator i = savedPointers.find(actualPointer);
+			auto i = savedPointers.find(actualPointer);
 			if(i != savedPointers.end())
 			{
 				//this pointer has been already serialized - write only it's id
@@ -250,7 +251,7 @@ public:
 		T *internalPtr = data.get();
 		save(internalPtr);
 	}
-	template <typename T, typename std::enable_if < !std::is_same<T, bool >::value, int  >::type = 0>
+	template <typename T, typename std::enable_if < !std::is_same<T, bool >::value && !is_bulk_serializeable<T>::value, int  >::type = 0>
 	void save(const std::vector<T> &data)
 	{
 		ui32 length = data.size();
@@ -258,6 +259,15 @@ public:
 		for(ui32 i=0;i<length;i++)
 			save(data[i]);
 	}
+	template <typename T, typename std::enable_if < is_bulk_serializeable<T>::value, int  >::type = 0>
+	void save(const std::vector<T> &data)
+	{
+		// same bytes as saving elements one by one
+		ui32 length = data.size();
+		*this & length;
+		if(length)
+			this->write(data.data(), length * sizeof(T));
+	}
 	template <typename T, size_t N>
 	void save(const std::array<T, N> &data)
 	{
@@ -354,11 +364,13 @@ public:
 	boost::filesystem::path fName;
 	std::unique_ptr<FileStream> sfile;
 
-	CSaveFile(const boost::filesystem::path &fname); //throws!
+	/// compressed file keeps header as is and deflates everything written after it
+	CSaveFile(const boost::filesystem::path &fname, bool compressed = false); //throws!
 	~CSaveFile();
 	int write(const void * data, unsigned size) override;
 
-	void openNextFile(const boost::filesystem::path &fname); //throws!
+	void openNextFile(const boost::filesystem::path &fname, bool compressed = false); //throws!
+	/// writes remaining compressed data and closes file
 	void clear();
 	void reportState(vstd::CLoggerBase * out) override;
 
@@ -370,4 +382,46 @@ public:
 		serializer & t;
 		return * this;
 	}
+
+private:
+	std::unique_ptr<z_stream_s> deflateStream;
+	/// data waiting for compression, serializer writes in very small pieces
+	std::vector<ui8> pendingData;
+	std::vector<ui8> compressedData;
+
+	void compressPending(int flush);
+	void finishCompression();
+	void endCompression();
+};
+
+/// Collects serialized data in memory, so it can be compressed and written to file later on background thread.
+/// Resulting file is same as if data was serialized by CSaveFile
+class DLL_LINKAGE CSaveBuffer : public IBinaryWriter
+{
+public:
+	BinarySerializer serializer;
+
+	CSaveBuffer();
+	int write(const void * data, unsigned size) override;
+
+	void putMagicBytes(const std::string &text);
+
+	template<class T>
+	CSaveBuffer & operator<<(const T &t)
+	{
+		serializer & t;
+		return * this;
+	}
+
+	size_t getSize() const;
+
+	/// Moves collected data to background thread that writes it to file, buffer is empty afterwards.
+	/// File is written under temporary name and replaces fname once complete
+	void writeInBackground(const boost::filesystem::path & fname, bool compressed);
+
+	/// Blocks until all background writes are finished
+	static void waitForBackgroundWrites();
+
+private:
+	std::vector<ui8> buffer;
 };
@@ -11,8 +11,9 @@
 
 #include "../ConstTransitivePtr.h"
 #include "../GameConstants.h"
+#include "../int3.h"
 
-const ui32 SERIALIZATION_VERSION = 787;
+const ui32 SERIALIZATION_VERSION = 788;
 const ui32 MINIMAL_SERIALIZATION_VERSION = 753;
 const std::string SAVEGAME_MAGIC = "VCMISVG";
 
@@ -143,6 +144,30 @@ struct is_serializeable
 	static const bool value = sizeof(Yes) == sizeof(is_serializeable::test((typename std::remove_reference<typename std::remove_cv<T>::type>::type*)0));
 };
 
+/// Helper to detect types serialized as plain copy of their memory: fundamental types except bool
+/// and structures of such fields without padding. Vectors of them are saved and loaded with single copy.
+/// FieldType is unit of byte order reversal for data of other endianness
+template<typename T, typename Enable = void>
+struct is_bulk_serializeable
+{
+	static const bool value = false;
+};
+
+template<typename T>
+struct is_bulk_serializeable<T, typename std::enable_if<std::is_fundamental<T>::value && !std::is_same<T, bool>::value>::type>
+{
+	static const bool value = true;
+	typedef T FieldType;
+};
+
+template<>
+struct is_bulk_serializeable<int3>
+{
+	static_assert(sizeof(int3) == 3 * sizeof(si32) && std::is_trivially_copyable<int3>::value, "int3 must be plain x, y, z");
+	static const bool value = true;
+	typedef si32 FieldType;
+};
+
 template <typename T> //metafunction returning CGObjectInstance if T is its derivate or T elsewise
 struct VectorizedTypeFor
 {
@@ -17,8 +17,13 @@ extern template void registerTypes<CTypeList>(CTypeList & s);
 CTypeList typeList;
 
 CTypeList::CTypeList()
+	: castTable(nullptr), castTableOutdated(true)
 {
+	castTables.push_back(make_unique<CastTable>());
+	castTable = castTables.back().get();
+
 	registerTypes(*this);
+	updateCastTable();
 }
 
 CTypeList::TypeInfoPtr CTypeList::registerType(const std::type_info *type)
@@ -37,6 +42,15 @@ CTypeList::TypeInfoPtr CTypeList::registerType(const std::type_info *type)
 
 ui16 CTypeList::getTypeID(const std::type_info *type, bool throws) const
 {
+	//flag is read before table, so that table published together with clearing of flag is never missed
+	const bool outdated = castTableOutdated;
+	if(ui16 typeID = castTable.load(std::memory_order_acquire)->findTypeID(type))
+		return typeID;
+
+	if(!outdated && !throws)
+		return 0;
+
+	TSharedLock lock(mx);
 	auto descriptor = getTypeDescriptor(type, throws);
 	if (descriptor == nullptr)
 	{
@@ -45,68 +59,121 @@ ui16 CTypeList::getTypeID(const std::type_info *type, bool throws) const
 	return descriptor->typeID;
 }
 
-std::vector<CTypeList::TypeInfoPtr> CTypeList::castSequence(TypeInfoPtr from, TypeInfoPtr to) const
+const CTypeList::TCastPath & CTypeList::castPath(const std::type_info *from, const std::type_info *to) const
 {
-	if(!strcmp(from->name, to->name))
-		return std::vector<CTypeList::TypeInfoPtr>();
+	static const TCastPath noCasts;
 
-	// Perform a simple BFS in the class hierarchy.
+	//This additional if is needed because getTypeDescriptor might fail if type is not registered
+	// (and if casting is not needed, then registereing should no  be required)
+	if(!strcmp(from->name(), to->name()))
+		return noCasts;
+
+	const bool outdated = castTableOutdated;
+	if(const TCastPath * path = castTable.load(std::memory_order_acquire)->findPath(from, to))
+		return *path;
+
+	if(outdated)
+	{
+		updateCastTable();
+		return castPath(from, to);
+	}
+
+	{
+		TSharedLock lock(mx);
+		getTypeDescriptor(from);
+		getTypeDescriptor(to);
+	}
+	THROW_FORMAT("Cannot find relation between types %s and %s. Were they (and all classes between them) properly registered?", from->name() % to->name());
+}
+
+void CTypeList::updateCastTable() const
+{
+	TUniqueLock lock(mx);
+	if(!castTableOutdated)
+		return;
+
+	castTables.push_back(buildCastTable());
+	castTable.store(castTables.back().get(), std::memory_order_release);
+	castTableOutdated = false;
+}
+
+std::unique_ptr<CTypeList::CastTable> CTypeList::buildCastTable() const
+{
+	auto table = make_unique<CastTable>();
+	for(auto & typeInfo : typeInfos)
+		table->typeIDs[typeInfo.second->name] = typeInfo.second->typeID;
 
-	auto BFS = [&](bool upcast)
+	// Perform a simple BFS in the class hierarchy from every type.
+	// Path to base classes is preferred, same as when path was searched on every cast.
+	for(auto & typeInfo : typeInfos)
 	{
-		std::map<TypeInfoPtr, TypeInfoPtr> previous;
-		std::queue<TypeInfoPtr> q;
-		q.push(to);
-		while(q.size())
+		const TypeInfoPtr to = typeInfo.second;
+		for(bool upcast : {true, false})
 		{
-			auto typeNode = q.front();
-			q.pop();
-			for(auto & weakNode : (upcast ? typeNode->parents : typeNode->children) )
+			std::map<TypeInfoPtr, TypeInfoPtr> previous;
+			std::queue<TypeInfoPtr> q;
+			q.push(to);
+			while(q.size())
 			{
-				auto nodeBase = weakNode.lock();
-				if(!previous.count(nodeBase))
+				auto typeNode = q.front();
+				q.pop();
+				for(auto & weakNode : (upcast ? typeNode->parents : typeNode->children) )
 				{
-					previous[nodeBase] = typeNode;
-					q.push(nodeBase);
+					auto nodeBase = weakNode.lock();
+					if(!previous.count(nodeBase))
+					{
+						previous[nodeBase] = typeNode;
+						q.push(nodeBase);
+					}
 				}
 			}
-		}
-
-		std::vector<TypeInfoPtr> ret;
-
-		if(!previous.count(from))
-			return ret;
-
-		ret.push_back(from);
-		TypeInfoPtr ptr = from;
-		do
-		{
-			ptr = previous.at(ptr);
-			ret.push_back(ptr);
-		} while(ptr != to);
 
-		return ret;
-	};
+			for(auto & found : previous)
+			{
+				const TypeInfoPtr & from = found.first;
+				const ui32 key = (static_cast<ui32>(from->typeID) << 16) | to->typeID;
+				if(from == to || table->paths.count(key))
+					continue;
+
+				TCastPath & path = table->paths[key];
+				TypeInfoPtr ptr = from;
+				do
+				{
+					auto next = previous.at(ptr);
+					path.push_back(casters.at(std::make_pair(ptr, next)).get());
+					ptr = next;
+				} while(ptr != to);
+			}
+		}
+	}
 
-	// Try looking both up and down.
-	auto ret = BFS(true);
-	if(ret.empty())
-		ret = BFS(false);
+	return table;
+}
 
-	if(ret.empty())
-		THROW_FORMAT("Cannot find relation between types %s and %s. Were they (and all classes between them) properly registered?", from->name % to->name);
+size_t CTypeList::CastTable::TypeNameHash::operator()(const char * name) const
+{
+	return boost::hash_range(name, name + strlen(name));
+}
 
-	return ret;
+ui16 CTypeList::CastTable::findTypeID(const std::type_info *type) const
+{
+	auto i = typeIDs.find(type->name());
+	if(i == typeIDs.end())
+		return 0;
+	return i->second;
 }
 
-std::vector<CTypeList::TypeInfoPtr> CTypeList::castSequence(const std::type_info *from, const std::type_info *to) const
+const CTypeList::TCastPath * CTypeList::CastTable::findPath(const std::type_info *from, const std::type_info *to) const
 {
-	//This additional if is needed because getTypeDescriptor might fail if type is not registered
-	// (and if casting is not needed, then registereing should no  be required)
-	if(!strcmp(from->name(), to->name()))
-		return std::vector<CTypeList::TypeInfoPtr>();
+	const ui32 fromID = findTypeID(from);
+	const ui32 toID = findTypeID(to);
+	if(!fromID || !toID)
+		return nullptr;
 
-	return castSequence(getTypeDescriptor(from), getTypeDescriptor(to));
+	auto i = paths.find((fromID << 16) | toID);
+	if(i == paths.end())
+		return nullptr;
+	return &i->second;
 }
 
 CTypeList::TypeInfoPtr CTypeList::getTypeDescriptor(const std::type_info *type, bool throws) const
@@ -13,7 +13,7 @@
 
 struct IPointerCaster
 {
-	virtual boost::any castRawPtr(const boost::any &ptr) const = 0; // takes From*, returns To*
+	virtual void * castRawPtr(void * ptr) const = 0; // takes From*, returns To*
 	virtual boost::any castSharedPtr(const boost::any &ptr) const = 0; // takes std::shared_ptr<From>, performs dynamic cast, returns std::shared_ptr<To>
 	virtual boost::any castWeakPtr(const boost::any &ptr) const = 0; // takes std::weak_ptr<From>, performs dynamic cast, returns std::weak_ptr<To>. The object under poitner must live.
 	//virtual boost::any castUniquePtr(const boost::any &ptr) const = 0; // takes std::unique_ptr<From>, performs dynamic cast, returns std::unique_ptr<To>
@@ -22,9 +22,9 @@ struct IPointerCaster
 template <typename From, typename To>
 struct PointerCaster : IPointerCaster
 {
-	virtual boost::any castRawPtr(const boost::any &ptr) const override // takes void* pointing to From object, performs dynamic cast, returns void* pointing to To object
+	virtual void * castRawPtr(void * ptr) const override // takes void* pointing to From object, performs static cast, returns void* pointing to To object
 	{
-		From * from = (From*)boost::any_cast<void*>(ptr);
+		From * from = (From*)ptr;
 		To * ret = static_cast<To*>(from);
 		return (void*)ret;
 	}
@@ -59,6 +59,8 @@ struct PointerCaster : IPointerCaster
 /// Class that implements basic reflection-like mechanisms
 /// For every type registered via registerType() generates inheritance tree
 /// Rarely used directly - usually used as part of CApplier
+/// Casts and type ids are looked up in immutable snapshot of the tree without locking,
+/// snapshot is rebuilt when needed after new relations are registered
 class DLL_LINKAGE CTypeList: public boost::noncopyable
 {
 //public:
@@ -74,35 +76,56 @@ class DLL_LINKAGE CTypeList: public boost::noncopyable
 	typedef boost::shared_mutex TMutex;
 	typedef boost::unique_lock<TMutex> TUniqueLock;
 	typedef boost::shared_lock<TMutex> TSharedLock;
+	/// Casters to apply one after another, every next type is derived from the previous or the other way round
+	typedef std::vector<const IPointerCaster *> TCastPath;
+
+	/// Type ids and cast paths between all related types, never changed after it is built
+	struct CastTable
+	{
+		/// Types are matched by name like in TypeComparer, as type_info of the same type may differ between libraries
+		struct TypeNameHash
+		{
+			size_t operator()(const char * name) const;
+		};
+		struct TypeNameEqual
+		{
+			bool operator()(const char * a, const char * b) const
+			{
+				return strcmp(a, b) == 0;
+			}
+		};
+
+		std::unordered_map<const char *, ui16, TypeNameHash, TypeNameEqual> typeIDs;
+		std::unordered_map<ui32, TCastPath> paths; //key is (from id << 16) | to id
+
+		ui16 findTypeID(const std::type_info *type) const; //0 if type is not in table
+		const TCastPath * findPath(const std::type_info *from, const std::type_info *to) const; //nullptr if types are not related
+	};
 private:
 	mutable TMutex mx;
 
 	std::map<const std::type_info *, TypeInfoPtr, TypeComparer> typeInfos;
 	std::map<std::pair<TypeInfoPtr, TypeInfoPtr>, std::unique_ptr<const IPointerCaster>> casters; //for each pair <Base, Der> we provide a caster (each registered relations creates a single entry here)
 
-	/// Returns sequence of types starting from "from" and ending on "to". Every next type is derived from the previous.
+	mutable std::atomic<const CastTable *> castTable;
+	mutable std::atomic<bool> castTableOutdated;
+	/// Replaced tables are kept, as other threads may still read them
+	mutable std::vector<std::unique_ptr<const CastTable>> castTables;
+
+	/// Rebuilds table if some relations were registered after it was built
+	void updateCastTable() const;
+	std::unique_ptr<CastTable> buildCastTable() const;
+
+	/// Returns casters that convert pointer to "from" into pointer to "to".
 	/// Throws if there is no link registered.
-	std::vector<TypeInfoPtr> castSequence(TypeInfoPtr from, TypeInfoPtr to) const;
-	std::vector<TypeInfoPtr> castSequence(const std::type_info *from, const std::type_info *to) const;
+	const TCastPath & castPath(const std::type_info *from, const std::type_info *to) const;
 
 	template<boost::any(IPointerCaster::*CastingFunction)(const boost::any &) const>
 	boost::any castHelper(boost::any inputPtr, const std::type_info *fromArg, const std::type_info *toArg) const
 	{
-		TSharedLock lock(mx);
-		auto typesSequence = castSequence(fromArg, toArg);
-
 		boost::any ptr = inputPtr;
-		for(int i = 0; i < static_cast<int>(typesSequence.size()) - 1; i++)
-		{
-			auto &from = typesSequence[i];
-			auto &to = typesSequence[i + 1];
-			auto castingPair = std::make_pair(from, to);
-			if(!casters.count(castingPair))
-				THROW_FORMAT("Cannot find caster for conversion %s -> %s which is needed to cast %s -> %s", from->name % to->name % fromArg->name() % toArg->name());
-
-			auto &caster = casters.at(castingPair);
-			ptr = (*caster.*CastingFunction)(ptr); //Why does unique_ptr not have operator->* ..?
-		}
+		for(const IPointerCaster * caster : castPath(fromArg, toArg))
+			ptr = (caster->*CastingFunction)(ptr);
 
 		return ptr;
 	}
@@ -132,11 +155,16 @@ public:
 		auto bti = registerType(bt);
 		auto dti = registerType(dt); //obtain our TypeDescriptor
 
+		//appliers register same relations again for every serializer
+		if(casters.count(std::make_pair(bti, dti)))
+			return;
+
 		// register the relation between classes
 		bti->children.push_back(dti);
 		dti->parents.push_back(bti);
 		casters[std::make_pair(bti, dti)] = make_unique<const PointerCaster<Base, Derived>>();
 		casters[std::make_pair(dti, bti)] = make_unique<const PointerCaster<Derived, Base>>();
+		castTableOutdated = true;
 	}
 
 	ui16 getTypeID(const std::type_info *type, bool throws = false) const;
@@ -158,9 +186,7 @@ public:
 			return const_cast<void*>(reinterpret_cast<const void*>(inputPtr));
 		}
 
-		return boost::any_cast<void*>(castHelper<&IPointerCaster::castRawPtr>(
-			const_cast<void*>(reinterpret_cast<const void*>(inputPtr)), &baseType,
-			derivedType));
+		return castRaw(const_cast<void*>(reinterpret_cast<const void*>(inputPtr)), &baseType, derivedType);
 	}
 
 	template<typename TInput>
@@ -177,7 +203,11 @@ public:
 
 	void * castRaw(void *inputPtr, const std::type_info *from, const std::type_info *to) const
 	{
-		return boost::any_cast<void*>(castHelper<&IPointerCaster::castRawPtr>(inputPtr, from, to));
+		void * ptr = inputPtr;
+		for(const IPointerCaster * caster : castPath(from, to))
+			ptr = caster->castRawPtr(ptr);
+
+		return ptr;
 	}
 	boost::any castShared(boost::any inputPtr, const std::type_info *from, const std::type_info *to) const
 	{
@@ -13,8 +13,15 @@
 #include "../registerTypes/RegisterTypes.h"
 #include "../mapping/CMap.h"
 #include "../CGameState.h"
+#include "../CThreadHelper.h"
+#include "../CConfigHandler.h"
 
 #include <boost/asio.hpp>
+#include <zlib.h>
+
+#ifndef VCMI_WINDOWS
+#include <poll.h>
+#endif
 
 using namespace boost;
 using namespace boost::asio::ip;
@@ -29,6 +36,27 @@ using namespace boost::asio::ip;
 #define LIL_ENDIAN
 #endif
 
+namespace
+{
+	void writeLittleEndian(ui8 * out, ui32 value)
+	{
+		for(ui32 i = 0; i < 4; i++)
+			out[i] = static_cast<ui8>(value >> (8 * i));
+	}
+
+	ui32 readLittleEndian(const ui8 * in)
+	{
+		ui32 value = 0;
+		for(ui32 i = 0; i < 4; i++)
+			value |= static_cast<ui32>(in[i]) << (8 * i);
+		return value;
+	}
+
+	double compressionRatio(const CConnection::PackTraffic & traffic)
+	{
+		return traffic.rawBytes ? 100.0 * traffic.bytes / traffic.rawBytes : 100.0;
+	}
+}
 
 void CConnection::init()
 {
@@ -46,11 +74,24 @@ void CConnection::init()
 	myEndianess = false;
 #endif
 	connected = true;
+	writeBuffer.assign(FRAME_HEADER_SIZE, 0);
+	readPosition = 0;
+	sendingStopped = false;
+	sendingAborted = false;
+	maxPendingBytes = DEFAULT_MAX_PENDING_BYTES;
+	compressionThreshold = 0; //handshake itself is never compressed
 	std::string pom;
+	ui32 ourCompressionThreshold = static_cast<ui32>(settings["server"]["compressionThreshold"].Integer());
+	ui32 contactCompressionThreshold = 0;
 	//we got connection
-	oser & std::string("Aiya!\n") & name & uuid & myEndianess; //identify ourselves
-	iser & pom & pom & contactUuid & contactEndianess;
-	logNetwork->info("Established connection with %s. UUID: %s", pom, contactUuid);
+	oser & std::string("Aiya!\n") & name & uuid & myEndianess & ourCompressionThreshold; //identify ourselves
+	writeFrame(*finishFrame(), "handshake");
+	iser & pom & pom & contactUuid & contactEndianess & contactCompressionThreshold;
+	if(ourCompressionThreshold && contactCompressionThreshold)
+		compressionThreshold = std::max(ourCompressionThreshold, contactCompressionThreshold);
+	receivedTraffic["handshake"] = pendingReceived;
+	pendingReceived = PackTraffic();
+	logNetwork->info("Established connection with %s. UUID: %s, compression threshold: %d", pom, contactUuid, compressionThreshold);
 	mutexRead = std::make_shared<boost::mutex>();
 	mutexWrite = std::make_shared<boost::mutex>();
 
@@ -131,11 +172,65 @@ CConnection::CConnection(std::shared_ptr<TAcceptor> acceptor, std::shared_ptr<bo
 }
 int CConnection::write(const void * data, unsigned size)
 {
+	auto bytes = static_cast<const ui8 *>(data);
+	writeBuffer.insert(writeBuffer.end(), bytes, bytes + size);
+	return size;
+}
+
+int CConnection::read(void * data, unsigned size)
+{
+	auto bytes = static_cast<ui8 *>(data);
+	unsigned copied = 0;
+
+	while(copied < size)
+	{
+		if(readPosition == readBuffer.size())
+			readFrame();
+
+		const size_t chunk = std::min<size_t>(size - copied, readBuffer.size() - readPosition);
+		std::copy_n(readBuffer.data() + readPosition, chunk, bytes + copied);
+		readPosition += chunk;
+		copied += chunk;
+	}
+	return size;
+}
+
+CConnection::TFrame CConnection::finishFrame()
+{
+	writeLittleEndian(writeBuffer.data(), static_cast<ui32>(writeBuffer.size() - FRAME_HEADER_SIZE));
+
+	auto frame = std::make_shared<std::vector<ui8>>(FRAME_HEADER_SIZE);
+	frame->swap(writeBuffer);
+	return frame;
+}
+
+void CConnection::writeFrame(const std::vector<ui8> & frame, const std::string & packType, bool interruptible)
+{
+	boost::unique_lock<boost::mutex> lock(socketWriteMx);
+
+	const std::vector<ui8> & data = compressFrame(frame) ? compressBuffer : frame;
+
+	ui64 syscalls = 0;
 	try
 	{
-		int ret;
-		ret = asio::write(*socket,asio::const_buffers_1(asio::const_buffer(data,size)));
-		return ret;
+		size_t sent = 0;
+		while(sent < data.size())
+		{
+			size_t chunk = data.size() - sent;
+			if(interruptible)
+			{
+				//blocking write can't be interrupted without touching socket from other thread
+				while(!waitWritable(SEND_POLL_MS))
+				{
+					if(sendingAborted)
+						throw std::runtime_error("Sending was aborted");
+				}
+				if(chunk > SEND_CHUNK_SIZE)
+					chunk = SEND_CHUNK_SIZE;
+			}
+			sent += socket->write_some(asio::buffer(data.data() + sent, chunk));
+			syscalls++;
+		}
 	}
 	catch(...)
 	{
@@ -143,27 +238,120 @@ int CConnection::write(const void * data, unsigned size)
 		connected = false;
 		throw;
 	}
+
+	boost::unique_lock<boost::mutex> trafficLock(sentTrafficMx);
+	PackTraffic & traffic = sentTraffic[packType];
+	traffic.frames++;
+	traffic.bytes += data.size();
+	traffic.rawBytes += frame.size();
+	traffic.syscalls += syscalls;
 }
-int CConnection::read(void * data, unsigned size)
+
+bool CConnection::waitWritable(int timeoutMs)
 {
-	try
+#ifdef VCMI_WINDOWS
+	WSAPOLLFD fd = {socket->native_handle(), POLLOUT, 0};
+	return WSAPoll(&fd, 1, timeoutMs) > 0;
+#else
+	pollfd fd = {socket->native_handle(), POLLOUT, 0};
+	return ::poll(&fd, 1, timeoutMs) > 0;
+#endif
+}
+
+bool CConnection::compressFrame(const std::vector<ui8> & frame)
+{
+	const size_t payloadSize = frame.size() - FRAME_HEADER_SIZE;
+	if(!compressionThreshold || payloadSize < compressionThreshold)
+		return false;
+
+	uLongf compressedSize = compressBound(payloadSize);
+	compressBuffer.resize(2 * FRAME_HEADER_SIZE + compressedSize);
+	if(compress2(compressBuffer.data() + 2 * FRAME_HEADER_SIZE, &compressedSize, frame.data() + FRAME_HEADER_SIZE, payloadSize, Z_BEST_SPEED) != Z_OK)
+		return false;
+
+	if(FRAME_HEADER_SIZE + compressedSize >= payloadSize)
+		return false; //not worth it, send as is
+
+	compressBuffer.resize(2 * FRAME_HEADER_SIZE + compressedSize);
+	writeLittleEndian(compressBuffer.data(), static_cast<ui32>(FRAME_HEADER_SIZE + compressedSize) | FRAME_COMPRESSED_FLAG);
+	writeLittleEndian(compressBuffer.data() + FRAME_HEADER_SIZE, static_cast<ui32>(payloadSize));
+	return true;
+}
+
+void CConnection::readFrame()
+{
+	auto receive = [this](ui8 * data, size_t size)
+	{
+		try
+		{
+			size_t received = 0;
+			while(received < size)
+			{
+				received += socket->read_some(asio::buffer(data + received, size - received));
+				pendingReceived.syscalls++;
+			}
+		}
+		catch(...)
+		{
+			//connection has been lost
+			connected = false;
+			throw;
+		}
+	};
+
+	ui8 header[FRAME_HEADER_SIZE];
+	receive(header, FRAME_HEADER_SIZE);
+
+	const ui32 sizeField = readLittleEndian(header);
+	const size_t payloadSize = sizeField & ~FRAME_COMPRESSED_FLAG;
+	readPosition = 0;
+
+	if(payloadSize > MAX_FRAME_SIZE)
+		throw std::runtime_error("Received frame exceeds size limit");
+
+	if(sizeField & FRAME_COMPRESSED_FLAG)
 	{
-		int ret = asio::read(*socket,asio::mutable_buffers_1(asio::mutable_buffer(data,size)));
-		return ret;
+		if(payloadSize < FRAME_HEADER_SIZE)
+			throw std::runtime_error("Received corrupted compressed frame");
+
+		compressedReadBuffer.resize(payloadSize);
+		receive(compressedReadBuffer.data(), payloadSize);
+
+		uLongf rawSize = readLittleEndian(compressedReadBuffer.data());
+		if(rawSize > MAX_FRAME_SIZE)
+			throw std::runtime_error("Received compressed frame exceeds size limit");
+
+		readBuffer.resize(rawSize);
+		if(uncompress(readBuffer.data(), &rawSize, compressedReadBuffer.data() + FRAME_HEADER_SIZE, payloadSize - FRAME_HEADER_SIZE) != Z_OK
+			|| rawSize != readBuffer.size())
+		{
+			throw std::runtime_error("Failed to decompress received frame");
+		}
 	}
-	catch(...)
+	else
 	{
-		//connection has been lost
-		connected = false;
-		throw;
+		readBuffer.resize(payloadSize);
+		receive(readBuffer.data(), payloadSize);
 	}
+
+	pendingReceived.frames++;
+	pendingReceived.bytes += FRAME_HEADER_SIZE + payloadSize;
+	pendingReceived.rawBytes += FRAME_HEADER_SIZE + readBuffer.size();
 }
+
 CConnection::~CConnection()
 {
 	if(handler)
 		handler->join();
 
 	close();
+
+	//sender thread is stopped now, so traffic is final
+	if(logNetwork->isDebugEnabled())
+	{
+		logNetwork->debug("Traffic of %s", toString());
+		logTraffic(logNetwork);
+	}
 }
 
 template<class T>
@@ -177,6 +365,9 @@ CConnection & CConnection::operator&(const T &t) {
 
 void CConnection::close()
 {
+	logSendQueueStats(logNetwork);
+	stopSending(); //send everything what is queued before closing
+
 	if(socket)
 	{
 		socket->close();
@@ -197,6 +388,60 @@ void CConnection::reportState(vstd::CLoggerBase * out)
 		out->debug("\tWe have an open and valid socket");
 		out->debug("\t %d bytes awaiting", socket->available());
 	}
+	logTraffic(out);
+}
+
+void CConnection::logTraffic(vstd::CLoggerBase * out) const
+{
+	auto logDirection = [out](const std::string & direction, const std::map<std::string, PackTraffic> & traffic)
+	{
+		for(auto & type : traffic)
+		{
+			out->debug("\t%s %s: %d frames, %d bytes (%.1f%% of %d uncompressed), %d syscalls", direction, type.first,
+				type.second.frames, type.second.bytes, compressionRatio(type.second), type.second.rawBytes, type.second.syscalls);
+		}
+	};
+
+	logDirection("Sent", getSentTraffic());
+	logDirection("Received", receivedTraffic);
+}
+
+void CConnection::logCompressionStats(vstd::CLoggerBase * out) const
+{
+	if(!compressionThreshold)
+		return;
+
+	const auto traffic = getSentTraffic();
+
+	PackTraffic total;
+	for(auto & type : traffic)
+	{
+		total.frames += type.second.frames;
+		total.bytes += type.second.bytes;
+		total.rawBytes += type.second.rawBytes;
+	}
+
+	out->info("Sent to %s: %d frames, %d bytes (%.1f%% of %d uncompressed)",
+		toString(), total.frames, total.bytes, compressionRatio(total), total.rawBytes);
+
+	for(auto & type : traffic)
+	{
+		if(type.second.bytes < type.second.rawBytes)
+			out->info("\t%s: %d frames, %d bytes (%.1f%% of %d uncompressed)",
+				type.first, type.second.frames, type.second.bytes, compressionRatio(type.second), type.second.rawBytes);
+	}
+}
+
+std::map<std::string, CConnection::PackTraffic> CConnection::getSentTraffic() const
+{
+	boost::unique_lock<boost::mutex> lock(sentTrafficMx);
+	return sentTraffic;
+}
+
+std::map<std::string, CConnection::PackTraffic> CConnection::getReceivedTraffic() const
+{
+	boost::unique_lock<boost::mutex> lock(*mutexRead);
+	return receivedTraffic;
 }
 
 CPack * CConnection::retrievePack()
@@ -204,7 +449,16 @@ CPack * CConnection::retrievePack()
 	CPack * pack = nullptr;
 	boost::unique_lock<boost::mutex> lock(*mutexRead);
 	iser & pack;
-	logNetwork->trace("Received CPack of type %s", (pack ? typeid(*pack).name() : "nullptr"));
+
+	const std::string packType = pack ? typeid(*pack).name() : "nullptr";
+	PackTraffic & traffic = receivedTraffic[packType];
+	traffic.frames += pendingReceived.frames;
+	traffic.bytes += pendingReceived.bytes;
+	traffic.rawBytes += pendingReceived.rawBytes;
+	traffic.syscalls += pendingReceived.syscalls;
+	pendingReceived = PackTraffic();
+
+	logNetwork->trace("Received CPack of type %s", packType);
 	if(pack == nullptr)
 	{
 		logNetwork->error("Received a nullptr CPack! You should check whether client and server ABI matches.");
@@ -218,9 +472,154 @@ CPack * CConnection::retrievePack()
 
 void CConnection::sendPack(const CPack * pack)
 {
-	boost::unique_lock<boost::mutex> lock(*mutexWrite);
 	logNetwork->trace("Sending a pack of type %s", typeid(*pack).name());
+	sendFrame(serializePack(pack), typeid(*pack).name());
+}
+
+CConnection::TFrame CConnection::serializePack(const CPack * pack)
+{
+	boost::unique_lock<boost::mutex> lock(*mutexWrite);
+
+	writeBuffer.resize(FRAME_HEADER_SIZE); //drop leftovers of pack which failed to serialize
 	oser & pack;
+	return finishFrame();
+}
+
+void CConnection::sendFrame(TFrame frame, const std::string & packType)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(sendQueueMx);
+		if(sender)
+		{
+			if(!connected) //sender thread already gave up
+				return;
+
+			sendQueue.push_back(QueuedFrame{frame, packType, boost::posix_time::microsec_clock::universal_time()});
+			sendQueueStats.frames++;
+			sendQueueStats.bytes += frame->size();
+			vstd::amax(sendQueueStats.maxFrames, sendQueueStats.frames);
+			vstd::amax(sendQueueStats.maxBytes, sendQueueStats.bytes);
+
+			//frame being written is not counted, so initial game state of large map can't get client dropped
+			if(sendQueue.size() > 1 && sendQueueStats.bytes > maxPendingBytes)
+				dropStalledClient();
+			else
+				sendQueueCond.notify_one();
+			return;
+		}
+	}
+	writeFrame(*frame, packType);
+}
+
+void CConnection::enableAsyncSending(size_t maxPending)
+{
+	boost::unique_lock<boost::mutex> lock(sendQueueMx);
+	maxPendingBytes = maxPending;
+	if(!sender)
+		sender = make_unique<boost::thread>(&CConnection::threadSendFrames, this);
+}
+
+CConnection::SendQueueStats CConnection::getSendQueueStats() const
+{
+	boost::unique_lock<boost::mutex> lock(sendQueueMx);
+	return sendQueueStats;
+}
+
+void CConnection::logSendQueueStats(vstd::CLoggerBase * out) const
+{
+	SendQueueStats stats;
+	{
+		boost::unique_lock<boost::mutex> lock(sendQueueMx);
+		if(!sender)
+			return;
+		stats = sendQueueStats;
+	}
+	out->info("Send queue of %s: %d frames, %d bytes pending (max %d frames, %d bytes), max stall %d ms",
+		toString(), stats.frames, stats.bytes, stats.maxFrames, stats.maxBytes, stats.maxStallMs);
+}
+
+void CConnection::dropStalledClient()
+{
+	logNetwork->error("%s does not receive data fast enough, %d bytes are waiting. Dropping connection.", toString(), sendQueueStats.bytes);
+	connected = false;
+	sendingAborted = true;
+	sendQueue.clear();
+	sendQueueStats.frames = 0;
+	sendQueueStats.bytes = 0;
+	sendQueueCond.notify_one();
+}
+
+void CConnection::threadSendFrames()
+{
+	setThreadName("CConnection::threadSendFrames");
+
+	while(true)
+	{
+		QueuedFrame next;
+		{
+			boost::unique_lock<boost::mutex> lock(sendQueueMx);
+			while(sendQueue.empty() && !sendingStopped && !sendingAborted)
+				sendQueueCond.wait(lock);
+
+			if(sendQueue.empty() || sendingAborted)
+				break;
+
+			next = std::move(sendQueue.front());
+			sendQueue.pop_front();
+			sendQueueStats.frames--;
+			sendQueueStats.bytes -= next.frame->size();
+		}
+
+		try
+		{
+			writeFrame(*next.frame, next.packType, true);
+		}
+		catch(std::exception & e)
+		{
+			if(!sendingAborted)
+				logNetwork->error("Failed to send %s to %s: %s", next.packType, toString(), e.what());
+
+			boost::unique_lock<boost::mutex> lock(sendQueueMx);
+			sendQueue.clear();
+			sendQueueStats.frames = 0;
+			sendQueueStats.bytes = 0;
+			break;
+		}
+
+		const auto stall = boost::posix_time::microsec_clock::universal_time() - next.queued;
+
+		boost::unique_lock<boost::mutex> lock(sendQueueMx);
+		vstd::amax(sendQueueStats.maxStallMs, static_cast<ui64>(stall.total_milliseconds()));
+	}
+
+	if(sendingAborted)
+	{
+		//unblocks reader waiting for client, done here as no other thread may use socket while we write
+		boost::system::error_code ec;
+		socket->shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+	}
+}
+
+void CConnection::stopSending()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(sendQueueMx);
+		if(!sender)
+			return;
+		sendingStopped = true;
+	}
+	sendQueueCond.notify_one();
+
+	if(!sender->timed_join(boost::posix_time::milliseconds(CLOSE_TIMEOUT_MS)))
+	{
+		boost::unique_lock<boost::mutex> lock(sendQueueMx);
+		dropStalledClient();
+	}
+	sender->join();
+
+	boost::unique_lock<boost::mutex> lock(sendQueueMx);
+	sender.reset();
+	sendingStopped = false;
 }
 
 void CConnection::disableStackSendingByID()
@@ -46,16 +46,104 @@ typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, boost::asio::so
 
 /// Main class for network communication
 /// Allows establishing connection and bidirectional read-write
+///
+/// Data is sent in frames: 4 bytes of little-endian payload size followed by payload.
+/// Each pack is serialized into memory and sent as single frame, reading side receives whole frame at once.
+/// If both sides allow it in handshake, large frames are deflated and marked by highest bit of size.
+/// Compressed payload starts with 4 bytes of uncompressed size.
 class DLL_LINKAGE CConnection
 	: public IBinaryReader, public IBinaryWriter, public std::enable_shared_from_this<CConnection>
 {
+public:
+	/// Complete serialized frame including header, immutable so it can be shared between connections
+	typedef std::shared_ptr<const std::vector<ui8>> TFrame;
+
+	/// Network traffic caused by packs of one type
+	struct PackTraffic
+	{
+		ui64 frames = 0;
+		ui64 bytes = 0; //including frame headers
+		ui64 rawBytes = 0; //bytes it would take without compression
+		ui64 syscalls = 0;
+	};
+
+	/// Backpressure of asynchronous sending
+	struct SendQueueStats
+	{
+		size_t frames = 0; //waiting in queue right now
+		size_t bytes = 0;
+		size_t maxFrames = 0; //highest values since async sending was enabled
+		size_t maxBytes = 0;
+		ui64 maxStallMs = 0; //longest time between queueing frame and finishing its write
+	};
+
+	/// Client which lets this much data pile up in its queue is disconnected instead of letting server run out of memory
+	static const size_t DEFAULT_MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+private:
+	enum : ui32 { FRAME_HEADER_SIZE = 4, FRAME_COMPRESSED_FLAG = 0x80000000 };
+	/// Largest payload, compressed or not, accepted from other side. Bigger frames are treated as corrupted.
+	static const size_t MAX_FRAME_SIZE = 256 * 1024 * 1024;
+	/// Sender thread writes at most this much at once and checks whether it should give up while waiting for socket
+	static const size_t SEND_CHUNK_SIZE = 64 * 1024;
+	static const int SEND_POLL_MS = 100;
+	/// How long closing connection waits for queued frames to be sent before dropping them
+	static const int CLOSE_TIMEOUT_MS = 5000;
+
 	void init();
 	void reportState(vstd::CLoggerBase * out) override;
 
 	int write(const void * data, unsigned size) override;
 	int read(void * data, unsigned size) override;
 
+	/// Turns everything written since last frame into new frame
+	TFrame finishFrame();
+	/// Interruptible writes are done in chunks and fail once sending is aborted, used by sender thread
+	void writeFrame(const std::vector<ui8> & frame, const std::string & packType, bool interruptible = false);
+	/// Waits until socket can accept more data, returns false on timeout
+	bool waitWritable(int timeoutMs);
+	/// Deflates frame into compressBuffer, returns false if frame is too small or incompressible
+	bool compressFrame(const std::vector<ui8> & frame);
+	void readFrame();
+	void logTraffic(vstd::CLoggerBase * out) const;
+
+	void threadSendFrames();
+	/// Waits for queued frames to be sent, gives up on them after CLOSE_TIMEOUT_MS
+	void stopSending();
+	/// Gives up on client which does not receive data, called with sendQueueMx held
+	/// Only signals sender thread, which then shuts socket down itself
+	void dropStalledClient();
+
+	struct QueuedFrame
+	{
+		TFrame frame;
+		std::string packType;
+		boost::posix_time::ptime queued;
+	};
+
 	std::shared_ptr<boost::asio::io_service> io_service; //can be empty if connection made from socket
+
+	std::vector<ui8> writeBuffer; //frame header placeholder followed by payload of frame being written
+	std::vector<ui8> readBuffer; //payload of last received frame
+	size_t readPosition;
+	std::vector<ui8> compressBuffer; //guarded by socketWriteMx
+	std::vector<ui8> compressedReadBuffer;
+	ui32 compressionThreshold; //negotiated in handshake, 0 if any side disallows compression
+
+	mutable boost::mutex socketWriteMx; //serialization and socket writes are guarded separately so packs can be serialized while other is sent
+	mutable boost::mutex sendQueueMx;
+	boost::condition_variable sendQueueCond;
+	std::deque<QueuedFrame> sendQueue; //frames waiting for sender thread
+	std::unique_ptr<boost::thread> sender;
+	bool sendingStopped;
+	std::atomic<bool> sendingAborted; //queued frames were dropped, sender thread shuts socket down and exits
+	size_t maxPendingBytes;
+	SendQueueStats sendQueueStats; //guarded by sendQueueMx
+
+	mutable boost::mutex sentTrafficMx; //separate from socketWriteMx so stats can be read while write is in progress
+	std::map<std::string, PackTraffic> sentTraffic; //by pack type, guarded by sentTrafficMx
+	std::map<std::string, PackTraffic> receivedTraffic; //by pack type, guarded by mutexRead
+	PackTraffic pendingReceived; //frames received for pack which is not deserialized yet
 public:
 	BinaryDeserializer iser;
 	BinarySerializer oser;
@@ -85,6 +173,20 @@ public:
 	CPack * retrievePack();
 	void sendPack(const CPack * pack);
 
+	/// Serializes pack into frame. Frame can be sent to other connections too as long as they are in same connection mode.
+	TFrame serializePack(const CPack * pack);
+	/// Sends frame immediately or queues it if asynchronous sending is enabled
+	void sendFrame(TFrame frame, const std::string & packType);
+	/// From now on frames are sent by separate thread in order they were queued, so sender is never blocked by slow client.
+	/// Queued frames are still sent on close unless it takes too long. Once more than maxPending bytes wait behind
+	/// the frame being written, client is considered stalled and dropped. Single large frame never counts as stall.
+	void enableAsyncSending(size_t maxPending = DEFAULT_MAX_PENDING_BYTES);
+	SendQueueStats getSendQueueStats() const;
+	/// Logs queue depth, pending bytes and worst stall, does nothing if async sending was never enabled
+	void logSendQueueStats(vstd::CLoggerBase * out) const;
+	/// Logs how much sent data was reduced by compression, in total and for each compressed pack type
+	void logCompressionStats(vstd::CLoggerBase * out) const;
+
 	void disableStackSendingByID();
 	void enableStackSendingByID();
 	void disableSmartPointerSerialization();
@@ -97,6 +199,9 @@ public:
 
 	std::string toString() const;
 
+	std::map<std::string, PackTraffic> getSentTraffic() const;
+	std::map<std::string, PackTraffic> getReceivedTraffic() const;
+
 	template<class T>
 	CConnection & operator>>(T &t)
 	{
@@ -108,6 +213,7 @@ public:
 	CConnection & operator<<(const T &t)
 	{
 		oser & t;
+		sendFrame(finishFrame(), typeid(T).name());
 		return * this;
 	}
 };
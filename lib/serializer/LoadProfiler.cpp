@@ -0,0 +1,39 @@
+/*
+ * LoadProfiler.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "LoadProfiler.h"
+
+namespace
+{
+	void keepProfiler(ILoadProfiler *)
+	{
+		//profiler is owned by whoever installed it
+	}
+
+	boost::thread_specific_ptr<ILoadProfiler> currentProfiler(&keepProfiler);
+}
+
+std::atomic<int> ILoadProfiler::installedCount(0);
+
+ILoadProfiler * ILoadProfiler::get()
+{
+	return currentProfiler.get();
+}
+
+void ILoadProfiler::set(ILoadProfiler * profiler)
+{
+	const bool wasInstalled = currentProfiler.get() != nullptr;
+	if(profiler && !wasInstalled)
+		installedCount++;
+	else if(!profiler && wasInstalled)
+		installedCount--;
+
+	currentProfiler.reset(profiler);
+}
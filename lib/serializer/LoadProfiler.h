@@ -0,0 +1,57 @@
+/*
+ * LoadProfiler.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+/// Receives nested sections of savegame loading: objects created through pointers and named steps like bonus tree fixes.
+/// Profiler is installed for one thread. While no thread has one, sections cost a single atomic load
+class DLL_LINKAGE ILoadProfiler
+{
+public:
+	virtual ~ILoadProfiler() = default;
+
+	/// name remains valid until the end of program
+	virtual void sectionStarted(const char * name) = 0;
+	virtual void sectionFinished() = 0;
+
+	/// Profiler of current thread, nullptr if none
+	static ILoadProfiler * get();
+	/// Installs profiler for current thread, nullptr removes it. Profiler is not owned
+	static void set(ILoadProfiler * profiler);
+
+	/// Whether any thread has profiler installed, checked before more expensive thread-local lookup
+	static bool anyInstalled()
+	{
+		return installedCount.load(std::memory_order_relaxed) != 0;
+	}
+
+private:
+	static std::atomic<int> installedCount;
+};
+
+/// Reports its scope as section to profiler of current thread, if any
+class DLL_LINKAGE LoadProfilerSection : public boost::noncopyable
+{
+public:
+	explicit LoadProfilerSection(const char * name)
+		: profiler(ILoadProfiler::anyInstalled() ? ILoadProfiler::get() : nullptr)
+	{
+		if(profiler)
+			profiler->sectionStarted(name);
+	}
+
+	~LoadProfilerSection()
+	{
+		if(profiler)
+			profiler->sectionFinished();
+	}
+
+private:
+	ILoadProfiler * profiler;
+};
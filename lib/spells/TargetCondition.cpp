@@ -116,10 +116,10 @@ public:
 protected:
 	bool check(const Mechanics * m, const battle::Unit * target) const override
 	{
-		std::stringstream cachingStr;
-		cachingStr << "type_" << Bonus::LEVEL_SPELL_IMMUNITY << "addInfo_1";
+		static const BonusCacheKey cachingKey("type_LEVEL_SPELL_IMMUNITYaddInfo_1");
+		static const auto selector = Selector::type(Bonus::LEVEL_SPELL_IMMUNITY).And(Selector::info(1));
 
-		TBonusListPtr levelImmunities = target->getBonuses(Selector::type(Bonus::LEVEL_SPELL_IMMUNITY).And(Selector::info(1)), cachingStr.str());
+		TBonusListPtr levelImmunities = target->getBonuses(selector, cachingKey);
 
 		if(levelImmunities->size() > 0 && levelImmunities->totalValue() >= m->getSpellLevel() && m->getSpellLevel() > 0)
 			return false;
@@ -139,9 +139,8 @@ public:
 protected:
 	bool check(const Mechanics * m, const battle::Unit * target) const override
 	{
-		std::stringstream cachingStr;
-		cachingStr << "type_" << Bonus::SPELL_IMMUNITY << "subtype_" << m->getSpellIndex() << "addInfo_1";
-		if(target->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingStr.str()))
+		auto cachingKey = BonusCacheKey::typeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1);
+		if(target->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingKey))
 			return false;
 		return true;
 	}
@@ -249,9 +248,7 @@ public:
 	SpellEffectCondition(SpellID spellID_)
 		: spellID(spellID_)
 	{
-		std::stringstream builder;
-		builder << "source_" << Bonus::SPELL_EFFECT << "id_" << spellID.num;
-		cachingString = builder.str();
+		cachingKey = BonusCacheKey::source(Bonus::SPELL_EFFECT, spellID.num);
 
 		selector = Selector::source(Bonus::SPELL_EFFECT, spellID.num);
 	}
@@ -259,12 +256,12 @@ public:
 protected:
 	bool check(const Mechanics * m, const battle::Unit * target) const override
 	{
-		return target->hasBonus(selector, cachingString);
+		return target->hasBonus(selector, cachingKey);
 	}
 
 private:
 	CSelector selector;
-	std::string cachingString;
+	BonusCacheKey cachingKey;
 	SpellID spellID;
 };
 
@@ -274,18 +271,18 @@ public:
 	ReceptiveFeatureCondition()
 	{
 		selector = Selector::type(Bonus::RECEPTIVE);
-		cachingString = "type_RECEPTIVE";
+		cachingKey = BonusCacheKey::type(Bonus::RECEPTIVE);
 	}
 
 protected:
 	bool check(const Mechanics * m, const battle::Unit * target) const override
 	{
-		return m->isPositiveSpell() && target->hasBonus(selector, cachingString);
+		return m->isPositiveSpell() && target->hasBonus(selector, cachingKey);
 	}
 
 private:
 	CSelector selector;
-	std::string cachingString;
+	BonusCacheKey cachingKey;
 };
 
 class ImmunityNegationCondition : public TargetConditionItemBase
@@ -269,9 +269,8 @@ bool UnitEffect::isReceptive(const Mechanics * m, const battle::Unit * unit) con
 		//ignore all immunities, except specific absolute immunity(VCMI addition)
 
 		//SPELL_IMMUNITY absolute case
-		std::stringstream cachingStr;
-		cachingStr << "type_" << Bonus::SPELL_IMMUNITY << "subtype_" << m->getSpellIndex() << "addInfo_1";
-		if(unit->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingStr.str()))
+		auto cachingKey = BonusCacheKey::typeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1);
+		if(unit->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingKey))
 			return false;
 
 		return true;
@@ -42,6 +42,8 @@
 #include "CVCMIServer.h"
 #include "../lib/CCreatureSet.h"
 #include "../lib/CThreadHelper.h"
+#include "../lib/CConfigHandler.h"
+#include "../lib/CStopWatch.h"
 #include "../lib/GameConstants.h"
 #include "../lib/registerTypes/RegisterTypes.h"
 #include "../lib/serializer/CTypeList.h"
@@ -1602,6 +1604,12 @@ void CGameHandler::setPortalDwelling(const CGTownInstance * town, bool forced=fa
 void CGameHandler::newTurn()
 {
 	logGlobal->trace("Turn %d", gs->day+1);
+	for(auto c : lobby->connections)
+	{
+		c->logSendQueueStats(logNetwork);
+		c->logCompressionStats(logNetwork);
+	}
+
 	NewTurn n;
 	n.specialWeek = NewTurn::NO_ACTION;
 	n.creatureid = CreatureID::NONE;
@@ -1830,12 +1838,10 @@ void CGameHandler::newTurn()
 				fw.mode = 1;
 				fw.player = player;
 				// find all hidden tiles
-				const auto & fow = getPlayerTeam(player)->fogOfWarMap;
-				for (size_t i=0; i<fow.size(); i++)
-					for (size_t j=0; j<fow.at(i).size(); j++)
-						for (size_t k=0; k<fow.at(i).at(j).size(); k++)
-							if (!fow.at(i).at(j).at(k))
-								fw.tiles.insert(int3(i,j,k));
+				getPlayerTeam(player)->fogOfWarMap.forEachTile(false, [&fw](const int3 & tile)
+				{
+					fw.tiles.insert(tile);
+				});
 
 				sendAndApply (&fw);
 			}
@@ -2697,12 +2703,18 @@ void CGameHandler::heroExchange(ObjectInstanceID hero1, ObjectInstanceID hero2)
 void CGameHandler::sendToAllClients(CPackForClient * pack)
 {
 	logNetwork->trace("\tSending to all clients: %s", typeid(*pack).name());
+
+	//all connections are in gameplay mode and serialize packs same way, so pack is serialized only once
+	CConnection::TFrame frame;
 	for (auto c : lobby->connections)
 	{
 		if(!c->isOpen())
 			continue;
 
-		c->sendPack(pack);
+		if(!frame)
+			frame = c->serializePack(pack);
+
+		c->sendFrame(frame, typeid(*pack).name());
 	}
 }
 
@@ -2752,13 +2764,32 @@ void CGameHandler::save(const std::string & filename)
 
 	try
 	{
+		const auto savePath = *CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME));
+		const bool compressed = settings["general"]["compressSaves"].Bool();
+		CStopWatch timer;
+
+		if(settings["general"]["backgroundSaving"].Bool())
 		{
-			CSaveFile save(*CResourceHandler::get("local")->getResourceName(ResourceID(stem.to_string(), EResType::SERVER_SAVEGAME)));
+			//game waits only for serialization into memory, file is written by background thread
+			CSaveBuffer save;
 			saveCommonState(save);
 			logGlobal->info("Saving server state");
 			save << *this;
+			logGlobal->info("Game state serialized in %d ms, %d KB", timer.getDiff(), save.getSize() / 1024);
+			//writer thread reports whether file was written
+			save.writeInBackground(savePath, compressed);
+		}
+		else
+		{
+			{
+				CSaveFile save(savePath, compressed);
+				saveCommonState(save);
+				logGlobal->info("Saving server state");
+				save << *this;
+			}
+			logGlobal->info("Game saved in %d ms, file size %d KB", timer.getDiff(), boost::filesystem::file_size(savePath) / 1024);
+			logGlobal->info("Game has been successfully saved!");
 		}
-		logGlobal->info("Game has been successfully saved!");
 	}
 	catch(std::exception &e)
 	{
@@ -6450,7 +6481,7 @@ void CGameHandler::handleCheatCode(std::string & cheat, PlayerColor player, cons
 		for (int i = 0; i < gs->map->width; i++)
 			for (int j = 0; j < gs->map->height; j++)
 				for (int k = 0; k < (gs->map->twoLevel ? 2 : 1); k++)
-					if (!fowMap.at(i).at(j).at(k) || !fc.mode)
+					if (!fowMap.isVisible(int3(i, j, k)) || !fc.mode)
 						hlp_tab[lastUnc++] = int3(i, j, k);
 		fc.tiles.insert(hlp_tab, hlp_tab + lastUnc);
 		delete [] hlp_tab;
@@ -6519,21 +6550,26 @@ void CGameHandler::removeAfterVisit(const CGObjectInstance *object)
 void CGameHandler::changeFogOfWar(int3 center, ui32 radius, PlayerColor player, bool hide)
 {
 	std::unordered_set<int3, ShashInt3> tiles;
-	getTilesInRange(tiles, center, radius, player, hide? -1 : 1);
 	if (hide)
 	{
-		std::unordered_set<int3, ShashInt3> observedTiles; //do not hide tiles observed by heroes. May lead to disastrous AI problems
+		//do not hide tiles observed by heroes. May lead to disastrous AI problems
+		FogOfWarMap hideable = gs->getPlayerTeam(player)->fogOfWarMap;
+		FogOfWarMap observed(hideable.getSizes());
 		auto p = getPlayer(player);
 		for (auto h : p->heroes)
-		{
-			getTilesInRange(observedTiles, h->getSightCenter(), h->getSightRadius(), h->tempOwner, -1);
-		}
+			observed.revealCircle(h->getSightCenter(), h->getSightRadius());
 		for (auto t : p->towns)
+			observed.revealCircle(t->getSightCenter(), t->getSightRadius());
+
+		hideable.subtract(observed);
+		hideable.forEachTileInCircle(center, radius, true, [&tiles](const int3 & tile)
 		{
-			getTilesInRange(observedTiles, t->getSightCenter(), t->getSightRadius(), t->tempOwner, -1);
-		}
-		for (auto tile : observedTiles)
-			vstd::erase_if_present (tiles, tile);
+			tiles.insert(tile);
+		});
+	}
+	else
+	{
+		getTilesInRange(tiles, center, radius, player, 1);
 	}
 	changeFogOfWar(tiles, player, hide);
 }
@@ -288,6 +288,7 @@ void CVCMIServer::connectionAccepted(const boost::system::error_code & ec)
 		logNetwork->info("We got a new connection! :)");
 		auto c = std::make_shared<CConnection>(upcomingConnection, NAME, uuid);
 		upcomingConnection.reset();
+		c->enableAsyncSending(); //slow client must not block lobby or game logic
 		connections.insert(c);
 		c->handler = std::make_shared<boost::thread>(&CVCMIServer::threadHandleClient, this, c);
 	}
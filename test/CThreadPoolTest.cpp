@@ -0,0 +1,75 @@
+/*
+ * CThreadPoolTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/CThreadPool.h"
+
+struct CThreadPoolTest : testing::Test
+{
+	CThreadPoolTest()
+		: subject(4)
+	{
+	}
+
+	CThreadPool subject;
+};
+
+TEST_F(CThreadPoolTest, runsAllTasks)
+{
+	std::vector<int> results(1000, 0);
+	std::vector<Task> tasks;
+
+	for(int i = 0; i < static_cast<int>(results.size()); i++)
+		tasks.push_back([&results, i](){ results[i] = i * 2; });
+
+	subject.run(tasks);
+
+	for(int i = 0; i < static_cast<int>(results.size()); i++)
+		EXPECT_EQ(results[i], i * 2);
+}
+
+TEST_F(CThreadPoolTest, runsNestedTasks)
+{
+	std::atomic<int> counter(0);
+	std::vector<Task> tasks;
+
+	for(int i = 0; i < 16; i++)
+	{
+		tasks.push_back([&]()
+		{
+			std::vector<Task> nested(16, [&](){ counter++; });
+			subject.run(nested);
+		});
+	}
+
+	subject.run(tasks);
+
+	EXPECT_EQ(counter, 16 * 16);
+}
+
+TEST_F(CThreadPoolTest, rethrowsTaskException)
+{
+	std::atomic<int> counter(0);
+	std::vector<Task> tasks(10, [&](){ counter++; });
+	tasks.push_back([](){ throw std::runtime_error("task failed"); });
+
+	EXPECT_THROW(subject.run(tasks), std::runtime_error);
+	EXPECT_EQ(counter, 10);
+}
+
+TEST(CThreadPoolWithoutWorkersTest, runsTasksInCallingThread)
+{
+	CThreadPool subject(0);
+
+	const auto caller = boost::this_thread::get_id();
+	std::vector<Task> tasks(3, [&](){ EXPECT_EQ(boost::this_thread::get_id(), caller); });
+
+	subject.run(tasks);
+}
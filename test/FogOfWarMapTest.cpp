@@ -0,0 +1,118 @@
+/*
+ * FogOfWarMapTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/FogOfWarMap.h"
+
+namespace
+{
+	std::set<int3> collectTiles(const FogOfWarMap & map, bool visible)
+	{
+		std::set<int3> tiles;
+		map.forEachTile(visible, [&tiles](const int3 & tile)
+		{
+			tiles.insert(tile);
+		});
+		return tiles;
+	}
+}
+
+TEST(FogOfWarMapTest, startsHidden)
+{
+	FogOfWarMap subject(int3(70, 3, 2));
+
+	EXPECT_TRUE(collectTiles(subject, true).empty());
+	EXPECT_EQ(collectTiles(subject, false).size(), 70 * 3 * 2);
+}
+
+TEST(FogOfWarMapTest, setsSingleTiles)
+{
+	FogOfWarMap subject(int3(70, 3, 2));
+
+	subject.setVisible(int3(64, 1, 1), true);
+	subject.setVisible(int3(0, 0, 0), true);
+	subject.setVisible(int3(0, 0, 0), false);
+
+	EXPECT_TRUE(subject.isVisible(int3(64, 1, 1)));
+	EXPECT_FALSE(subject.isVisible(int3(63, 1, 1)));
+	EXPECT_FALSE(subject.isVisible(int3(64, 1, 0)));
+	EXPECT_FALSE(subject.isVisible(int3(0, 0, 0)));
+	EXPECT_EQ(collectTiles(subject, true), std::set<int3>{int3(64, 1, 1)});
+}
+
+TEST(FogOfWarMapTest, revealsSameTilesAsRangeCheck)
+{
+	const int3 sizes(67, 20, 2);
+
+	//radii above 64 are not precomputed
+	for(int radius : {0, 1, 2, 5, 11, 64, 65, 80})
+	{
+		for(const int3 & center : {int3(0, 0, 0), int3(33, 10, 1), int3(66, 19, 0), int3(-3, 25, 1), int3(64, 5, 0)})
+		{
+			FogOfWarMap subject(sizes);
+			subject.revealCircle(center, radius);
+
+			std::set<int3> expected;
+			for(int y = 0; y < sizes.y; y++)
+			{
+				for(int x = 0; x < sizes.x; x++)
+				{
+					const int3 tile(x, y, center.z);
+					if(static_cast<int>(center.dist(tile, int3::DIST_2D)) <= radius)
+						expected.insert(tile);
+				}
+			}
+
+			EXPECT_EQ(collectTiles(subject, true), expected) << "radius " << radius << ", center " << center.toString();
+
+			std::set<int3> hiddenInCircle;
+			FogOfWarMap(sizes).forEachTileInCircle(center, radius, false, [&hiddenInCircle](const int3 & tile)
+			{
+				hiddenInCircle.insert(tile);
+			});
+			EXPECT_EQ(hiddenInCircle, expected) << "radius " << radius << ", center " << center.toString();
+		}
+	}
+}
+
+TEST(FogOfWarMapTest, combinesMaps)
+{
+	FogOfWarMap first(int3(40, 40, 1));
+	FogOfWarMap second(int3(40, 40, 1));
+	first.revealCircle(int3(10, 10, 0), 5);
+	second.revealCircle(int3(14, 10, 0), 5);
+
+	FogOfWarMap both = first;
+	both &= second;
+	FogOfWarMap any = first;
+	any |= second;
+	FogOfWarMap onlyFirst = first;
+	onlyFirst.subtract(second);
+
+	for(int y = 0; y < 40; y++)
+	{
+		for(int x = 0; x < 40; x++)
+		{
+			const int3 tile(x, y, 0);
+			EXPECT_EQ(both.isVisible(tile), first.isVisible(tile) && second.isVisible(tile));
+			EXPECT_EQ(any.isVisible(tile), first.isVisible(tile) || second.isVisible(tile));
+			EXPECT_EQ(onlyFirst.isVisible(tile), first.isVisible(tile) && !second.isVisible(tile));
+		}
+	}
+}
+
+TEST(FogOfWarMapTest, revealsWholeMapWithNegativeRadius)
+{
+	FogOfWarMap subject(int3(5, 5, 2));
+	subject.revealCircle(int3(2, 2, 0), -1);
+
+	EXPECT_EQ(collectTiles(subject, true).size(), 5 * 5 * 2);
+	EXPECT_TRUE(collectTiles(subject, false).empty());
+}
@@ -0,0 +1,109 @@
+/*
+ * JsonNodeBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../lib/JsonNode.h"
+#include "../lib/filesystem/Filesystem.h"
+
+namespace
+{
+	/// bookkeeping of one std::map element besides key and value
+	const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void *);
+
+	struct TreeStats
+	{
+		size_t nodes = 0;
+		size_t bytes = 0;
+	};
+
+	size_t stringBuffer(const std::string & value)
+	{
+		//short strings are kept inside of std::string itself
+		return value.capacity() >= sizeof(std::string) ? value.capacity() + 1 : 0;
+	}
+
+	/// Approximate heap memory used by children of node: child nodes, containers and string buffers.
+	/// Shared metadata is stored once per value, so it is not counted
+	void collectStats(const JsonNode & node, TreeStats & stats)
+	{
+		stats.nodes++;
+		switch(node.getType())
+		{
+		case JsonNode::JsonType::DATA_STRING:
+			stats.bytes += sizeof(std::string) + stringBuffer(node.String());
+			break;
+		case JsonNode::JsonType::DATA_VECTOR:
+			stats.bytes += sizeof(JsonVector) + node.Vector().capacity() * sizeof(JsonNode);
+			for(const JsonNode & entry : node.Vector())
+				collectStats(entry, stats);
+			break;
+		case JsonNode::JsonType::DATA_STRUCT:
+			stats.bytes += sizeof(JsonMap);
+			for(const auto & entry : node.Struct())
+			{
+				stats.bytes += MAP_NODE_OVERHEAD + sizeof(JsonMap::value_type) + stringBuffer(entry.first);
+				collectStats(entry.second, stats);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	std::vector<std::pair<std::unique_ptr<ui8[]>, si64>> readConfigFiles()
+	{
+		auto files = CResourceHandler::get()->getFilteredFiles([](const ResourceID & resID)
+		{
+			return resID.getType() == EResType::TEXT && boost::starts_with(resID.getName(), "CONFIG/");
+		});
+
+		std::vector<std::pair<std::unique_ptr<ui8[]>, si64>> result;
+		for(const ResourceID & file : files)
+			result.push_back(CResourceHandler::get()->load(file)->readAll());
+		return result;
+	}
+}
+
+TEST(JsonNodeBenchmark, DISABLED_ParseConfigDirectory)
+{
+	const int rounds = 20;
+
+	const auto files = readConfigFiles();
+	ASSERT_FALSE(files.empty());
+
+	size_t totalSize = 0;
+	for(const auto & file : files)
+		totalSize += file.second;
+
+	std::vector<JsonNode> trees(files.size());
+
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < rounds; i++)
+	{
+		for(size_t j = 0; j < files.size(); j++)
+		{
+			//same steps as loading of mod data does
+			trees[j] = JsonNode(reinterpret_cast<const char *>(files[j].first.get()), files[j].second);
+			trees[j].setMeta("core");
+		}
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	TreeStats stats;
+	for(const JsonNode & tree : trees)
+	{
+		stats.bytes += sizeof(JsonNode);
+		collectStats(tree, stats);
+	}
+
+	std::cout << boost::format("Parsed %d files, %.1f KB: %.1f MB/s") % files.size() % (totalSize / 1024.0) % (totalSize * rounds / seconds / 1e6) << std::endl;
+	std::cout << boost::format("Trees: %d nodes, %d bytes per node, %.1f KB in total, %.1f bytes per node in total")
+		% stats.nodes % sizeof(JsonNode) % (stats.bytes / 1024.0) % (static_cast<double>(stats.bytes) / stats.nodes) << std::endl;
+}
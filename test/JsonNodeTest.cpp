@@ -0,0 +1,143 @@
+/*
+ * JsonNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../lib/JsonNode.h"
+#include "../lib/serializer/CMemorySerializer.h"
+
+namespace
+{
+	const std::string TEST_DATA = R"({
+		"name" : "test",
+		"list" : [ 1, "two", { "three" : 3 } ],
+		"child#override" : { "flag" : false }
+	})";
+
+	JsonNode parse(const std::string & text)
+	{
+		return JsonNode(text.c_str(), text.size());
+	}
+
+	/// Checks that node and all its children refer to same shared metadata
+	void expectSharedMeta(const JsonNode & node, const JsonSharedValue<std::string> & meta)
+	{
+		EXPECT_TRUE(node.meta == meta);
+		if(node.getType() == JsonNode::JsonType::DATA_VECTOR)
+		{
+			for(const JsonNode & entry : node.Vector())
+				expectSharedMeta(entry, meta);
+		}
+		if(node.getType() == JsonNode::JsonType::DATA_STRUCT)
+		{
+			for(const auto & entry : node.Struct())
+				expectSharedMeta(entry.second, meta);
+		}
+	}
+}
+
+TEST(JsonSharedValueTest, emptyValue)
+{
+	JsonSharedValue<std::string> value;
+	EXPECT_TRUE(value.empty());
+	EXPECT_EQ(value.get(), "");
+
+	JsonSharedValue<std::string> assigned(std::string(""));
+	EXPECT_TRUE(assigned.empty());
+	EXPECT_TRUE(assigned == value);
+}
+
+TEST(JsonSharedValueTest, equalValuesAreStoredOnce)
+{
+	const JsonSharedValue<std::string> core(std::string("core"));
+	const JsonSharedValue<std::string> mod(std::string("mod"));
+	const JsonSharedValue<std::string> coreAgain(std::string("core"));
+
+	EXPECT_EQ(core.get(), "core");
+	EXPECT_EQ(mod.get(), "mod");
+	EXPECT_TRUE(core == coreAgain);
+	EXPECT_TRUE(core != mod);
+	EXPECT_EQ(&core.get(), &coreAgain.get());
+}
+
+TEST(JsonSharedValueTest, valuesAreSharedBetweenThreads)
+{
+	const JsonSharedValue<std::vector<std::string>> local(std::vector<std::string>{"override"});
+
+	JsonSharedValue<std::vector<std::string>> other;
+	boost::thread thread([&]()
+	{
+		other = JsonSharedValue<std::vector<std::string>>(std::vector<std::string>{"override"});
+	});
+	thread.join();
+
+	EXPECT_TRUE(local == other);
+}
+
+TEST(JsonNodeTest, moveConstructorTakesData)
+{
+	JsonNode source = parse(TEST_DATA);
+	source.setMeta("core");
+	const JsonNode copy = source;
+
+	JsonNode moved(std::move(source));
+
+	EXPECT_TRUE(moved == copy);
+	EXPECT_TRUE(moved.meta == copy.meta);
+	EXPECT_EQ(moved.meta.get(), "core");
+	EXPECT_EQ(moved["child"].flags.get(), std::vector<std::string>{"override"});
+
+	EXPECT_TRUE(source.isNull());
+	EXPECT_TRUE(source.meta.empty());
+	EXPECT_TRUE(source.flags.empty());
+}
+
+TEST(JsonNodeTest, copyConstructorSharesMetaAndFlags)
+{
+	JsonNode source = parse(TEST_DATA);
+	source.setMeta("core");
+
+	const JsonNode copy = source;
+	EXPECT_TRUE(copy == source);
+	expectSharedMeta(copy, source.meta);
+	EXPECT_TRUE(copy["child"].flags == source["child"].flags);
+	EXPECT_EQ(&copy["child"].flags.get(), &source["child"].flags.get());
+}
+
+TEST(JsonNodeTest, setMetaSharesValueWithChildren)
+{
+	JsonNode node = parse(TEST_DATA);
+
+	node.setMeta("mod");
+	expectSharedMeta(node, node.meta);
+	EXPECT_EQ(node["list"].Vector()[2]["three"].meta.get(), "mod");
+
+	//not recursive
+	node["list"].setMeta("other", false);
+	EXPECT_EQ(node["list"].meta.get(), "other");
+	EXPECT_EQ(node["list"].Vector()[0].meta.get(), "mod");
+	EXPECT_EQ(node["name"].meta.get(), "mod");
+}
+
+TEST(JsonNodeTest, loadedNodesShareMetaAndFlags)
+{
+	JsonNode source = parse(TEST_DATA);
+	source.setMeta("core");
+
+	CMemorySerializer mem;
+	mem.oser & source;
+
+	JsonNode loaded;
+	mem.iser & loaded;
+
+	EXPECT_TRUE(loaded == source);
+	expectSharedMeta(loaded, source.meta);
+	EXPECT_TRUE(loaded["child"].flags == source["child"].flags);
+	EXPECT_TRUE(loaded["name"].flags.empty());
+}
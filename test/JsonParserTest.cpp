@@ -0,0 +1,93 @@
+/*
+ * JsonParserTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../lib/JsonDetail.h"
+
+namespace
+{
+	/// Writes every event as one line of text
+	class EventRecorder : public IJsonEventHandler
+	{
+	public:
+		std::vector<std::string> events;
+
+		void onNull() override { events.push_back("null"); }
+		void onBool(bool value) override { events.push_back(value ? "true" : "false"); }
+		void onInteger(si64 value) override { events.push_back("int " + std::to_string(value)); }
+		void onFloat(double value) override { events.push_back("float " + std::to_string(value)); }
+		void onString(std::string & value) override { events.push_back("string " + value); }
+		void onStructBegin() override { events.push_back("{"); }
+
+		bool onStructKey(const std::string & key, const std::vector<std::string> & flags) override
+		{
+			events.push_back("key " + key + (flags.empty() ? "" : " #" + boost::algorithm::join(flags, "#")));
+			return true;
+		}
+
+		void onStructEnd() override { events.push_back("}"); }
+		void onArrayBegin() override { events.push_back("["); }
+		void onArrayEnd() override { events.push_back("]"); }
+	};
+
+	const std::string TEST_DATA = R"({
+		"name" : "test",
+		"list" : [ 1, -2.5, true, null, {} ],
+		"child#override" : { "flag" : false }
+	})";
+}
+
+TEST(JsonParserTest, reportsEventsInDocumentOrder)
+{
+	EventRecorder recorder;
+	JsonParser parser(TEST_DATA.c_str(), TEST_DATA.size());
+	parser.parse("test", recorder);
+
+	const std::vector<std::string> expected =
+	{
+		"{",
+		"key name", "string test",
+		"key list", "[", "int 1", "float -2.500000", "true", "null", "{", "}", "]",
+		"key child #override", "{", "key flag", "false", "}",
+		"}"
+	};
+
+	EXPECT_TRUE(parser.isValid());
+	EXPECT_EQ(recorder.events, expected);
+}
+
+TEST(JsonParserTest, buildsSameTreeAsJsonNode)
+{
+	JsonTreeBuilder builder;
+	JsonParser parser(TEST_DATA.c_str(), TEST_DATA.size());
+	parser.parse("test", builder);
+
+	const JsonNode & root = builder.root;
+
+	EXPECT_EQ(root, JsonNode(TEST_DATA.c_str(), TEST_DATA.size()));
+	EXPECT_EQ(root["name"].String(), "test");
+	EXPECT_EQ(root["list"].Vector().size(), 5);
+	EXPECT_EQ(root["list"].Vector()[0].Integer(), 1);
+	EXPECT_TRUE(root["list"].Vector()[4].getType() == JsonNode::JsonType::DATA_STRUCT);
+	EXPECT_EQ(root["child"].flags.get(), std::vector<std::string>{"override"});
+	EXPECT_FALSE(root["child"]["flag"].Bool());
+}
+
+TEST(JsonParserTest, reportsDuplicatedKeys)
+{
+	const std::string data = R"({ "a" : 1, "a" : 2 })";
+
+	JsonTreeBuilder builder;
+	JsonParser parser(data.c_str(), data.size());
+	parser.parse("test", builder);
+
+	EXPECT_FALSE(parser.isValid());
+	EXPECT_EQ(builder.root["a"].Integer(), 2);
+}
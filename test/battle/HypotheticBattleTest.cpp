@@ -0,0 +1,142 @@
+/*
+ * HypotheticBattleTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../AI/BattleAI/StackWithBonuses.h"
+#include "../../lib/JsonNode.h"
+
+#include "mock/mock_battle_IBattleState.h"
+
+using namespace testing;
+
+class HypotheticBattleTest : public Test
+{
+public:
+	class TestSubject : public CBattleInfoCallback
+	{
+	public:
+		void setBattle(const IBattleInfo * battleInfo)
+		{
+			CBattleInfoCallback::setBattle(battleInfo);
+		}
+	};
+
+	NiceMock<BattleStateMock> battleMock;
+	CBonusSystemNode battleNode;
+	std::shared_ptr<TestSubject> subject;
+
+	void SetUp() override
+	{
+		ON_CALL(battleMock, asBearer()).WillByDefault(Return(&battleNode));
+
+		subject = std::make_shared<TestSubject>();
+		subject->setBattle(&battleMock);
+	}
+
+	static JsonNode unitData(BattleHex position)
+	{
+		battle::UnitInfo info;
+		info.count = 10;
+		info.type = CreatureID(0);
+		info.side = BattleSide::ATTACKER;
+		info.position = position;
+
+		JsonNode data;
+		info.save(data);
+		return data;
+	}
+
+	static BattleHex unitPosition(const HypotheticBattle & battle, uint32_t id)
+	{
+		const StackWithBonuses * unit = battle.getUnitState(id);
+		if(!unit)
+			return BattleHex::INVALID;
+		return unit->getPosition();
+	}
+};
+
+TEST_F(HypotheticBattleTest, forkDoesNotChangeParent)
+{
+	HypotheticBattle parent(subject);
+	parent.addUnit(1, unitData(BattleHex(20)));
+
+	HypotheticBattle fork(parent);
+	EXPECT_EQ(fork.getUnitState(1), parent.getUnitState(1));
+
+	fork.moveUnit(1, BattleHex(21));
+	fork.addUnit(2, unitData(BattleHex(30)));
+
+	EXPECT_EQ(unitPosition(fork, 1), BattleHex(21));
+	EXPECT_EQ(unitPosition(parent, 1), BattleHex(20));
+	EXPECT_NE(fork.getUnitState(1), parent.getUnitState(1));
+	EXPECT_TRUE(parent.getUnitState(2) == nullptr);
+}
+
+TEST_F(HypotheticBattleTest, snapshotRollsBackChanges)
+{
+	HypotheticBattle battle(subject);
+	battle.addUnit(1, unitData(BattleHex(20)));
+
+	const HypotheticBattle snapshot(battle);
+
+	battle.moveUnit(1, BattleHex(22));
+	battle.addUnitBonus(1, {Bonus(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::SPELL_EFFECT, 5, 0, PrimarySkill::ATTACK)});
+
+	EXPECT_EQ(unitPosition(battle, 1), BattleHex(22));
+	EXPECT_EQ(battle.getUnitState(1)->bonusesToAdd.size(), 1);
+
+	//going back is forking again from kept snapshot
+	HypotheticBattle rolledBack(snapshot);
+	EXPECT_EQ(unitPosition(rolledBack, 1), BattleHex(20));
+	EXPECT_TRUE(rolledBack.getUnitState(1)->bonusesToAdd.empty());
+	EXPECT_EQ(rolledBack.getTreeVersion(), snapshot.getTreeVersion());
+	EXPECT_NE(battle.getTreeVersion(), snapshot.getTreeVersion());
+}
+
+TEST_F(HypotheticBattleTest, unsharedStateIsUpdatedInPlace)
+{
+	HypotheticBattle battle(subject);
+	battle.addUnit(1, unitData(BattleHex(20)));
+
+	const StackWithBonuses * state = battle.getUnitState(1);
+	battle.moveUnit(1, BattleHex(21));
+	EXPECT_EQ(battle.getUnitState(1), state);
+
+	HypotheticBattle fork(battle);
+	battle.moveUnit(1, BattleHex(22));
+	EXPECT_NE(battle.getUnitState(1), state);
+	EXPECT_EQ(fork.getUnitState(1), state);
+
+	//fork is the only owner of old state now
+	fork.moveUnit(1, BattleHex(23));
+	EXPECT_EQ(fork.getUnitState(1), state);
+	EXPECT_EQ(unitPosition(fork, 1), BattleHex(23));
+	EXPECT_EQ(unitPosition(battle, 1), BattleHex(22));
+}
+
+TEST_F(HypotheticBattleTest, detachedCopyDoesNotShareStates)
+{
+	HypotheticBattle parent(subject);
+	parent.addUnit(1, unitData(BattleHex(20)));
+	parent.addUnitBonus(1, {Bonus(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::SPELL_EFFECT, 5, 0, PrimarySkill::ATTACK)});
+
+	HypotheticBattle detached = parent.detachedCopy();
+
+	ASSERT_TRUE(detached.getUnitState(1) != nullptr);
+	EXPECT_NE(detached.getUnitState(1), parent.getUnitState(1));
+	EXPECT_EQ(unitPosition(detached, 1), BattleHex(20));
+	EXPECT_EQ(detached.getUnitState(1)->bonusesToAdd.size(), 1);
+	EXPECT_EQ(detached.getTreeVersion(), parent.getTreeVersion());
+
+	const StackWithBonuses * state = detached.getUnitState(1);
+	detached.moveUnit(1, BattleHex(21));
+	EXPECT_EQ(detached.getUnitState(1), state);
+	EXPECT_EQ(unitPosition(parent, 1), BattleHex(20));
+}
@@ -0,0 +1,70 @@
+/*
+ * CBonusSystemNodeBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/HeroBonus.h"
+
+using namespace testing;
+
+namespace
+{
+	const int BENCHMARK_DURATION_MS = 500;
+}
+
+TEST(CBonusSystemNodeBenchmark, DISABLED_ContendedCachedLookups)
+{
+	CBonusSystemNode global;
+	CBonusSystemNode hero;
+	CBonusSystemNode stack;
+
+	hero.attachTo(&global);
+	stack.attachTo(&hero);
+
+	for(int i = 0; i < 30; i++)
+	{
+		global.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 1, i, i % 4));
+		hero.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::STACKS_SPEED, Bonus::OTHER, 1, i));
+	}
+
+	const auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, 0);
+	const auto cachingKey = BonusCacheKey::type(Bonus::PRIMARY_SKILL, 0);
+
+	const int expected = stack.valOfBonuses(selector, cachingKey);
+
+	for(int threadsCount : {1, 2, 4, 8})
+	{
+		std::atomic<bool> stop(false);
+		std::atomic<int64_t> lookups(0);
+		boost::thread_group threads;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for(int i = 0; i < threadsCount; i++)
+		{
+			threads.create_thread([&]()
+			{
+				int64_t done = 0;
+				while(!stop)
+				{
+					EXPECT_EQ(stack.valOfBonuses(selector, cachingKey), expected);
+					done++;
+				}
+				lookups += done;
+			});
+		}
+
+		boost::this_thread::sleep(boost::posix_time::milliseconds(BENCHMARK_DURATION_MS));
+		stop = true;
+		threads.join_all();
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << boost::format("%d thread(s): %.0f lookups/s") % threadsCount % (lookups / seconds) << std::endl;
+	}
+}
@@ -0,0 +1,176 @@
+/*
+ * CBonusSystemNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/HeroBonus.h"
+
+using namespace testing;
+
+class CBonusSystemNodeTest : public Test
+{
+public:
+	CBonusSystemNode parent;
+	CBonusSystemNode child;
+	CBonusSystemNode unrelated;
+
+	void SetUp() override
+	{
+		child.attachTo(&parent);
+	}
+
+	static std::shared_ptr<Bonus> makeBonus(Bonus::BonusType type, int val)
+	{
+		return std::make_shared<Bonus>(Bonus::PERMANENT, type, Bonus::OTHER, val, 0);
+	}
+};
+
+TEST_F(CBonusSystemNodeTest, ChildInheritsParentBonuses)
+{
+	EXPECT_EQ(child.valOfBonuses(Bonus::STACKS_SPEED), 0);
+
+	parent.addNewBonus(makeBonus(Bonus::STACKS_SPEED, 3));
+
+	EXPECT_EQ(child.valOfBonuses(Bonus::STACKS_SPEED), 3);
+	EXPECT_EQ(unrelated.valOfBonuses(Bonus::STACKS_SPEED), 0);
+}
+
+TEST_F(CBonusSystemNodeTest, LocalChangeInvalidatesSubtreeOnly)
+{
+	const int64_t parentVersion = parent.getTreeVersion();
+	const int64_t childVersion = child.getTreeVersion();
+	const int64_t unrelatedVersion = unrelated.getTreeVersion();
+
+	child.addNewBonus(makeBonus(Bonus::STACKS_SPEED, 1));
+
+	EXPECT_EQ(parent.getTreeVersion(), parentVersion);
+	EXPECT_NE(child.getTreeVersion(), childVersion);
+	EXPECT_EQ(unrelated.getTreeVersion(), unrelatedVersion);
+
+	const int64_t childVersion2 = child.getTreeVersion();
+
+	parent.addNewBonus(makeBonus(Bonus::STACKS_SPEED, 2));
+
+	EXPECT_NE(parent.getTreeVersion(), parentVersion);
+	EXPECT_NE(child.getTreeVersion(), childVersion2);
+	EXPECT_EQ(unrelated.getTreeVersion(), unrelatedVersion);
+}
+
+TEST_F(CBonusSystemNodeTest, CachedRequestIsRefreshedAfterParentChange)
+{
+	const auto cachingKey = BonusCacheKey::type(Bonus::STACKS_SPEED);
+	auto selector = Selector::type(Bonus::STACKS_SPEED);
+
+	parent.addNewBonus(makeBonus(Bonus::STACKS_SPEED, 1));
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 1);
+
+	auto bonus = makeBonus(Bonus::STACKS_SPEED, 2);
+	parent.addNewBonus(bonus);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 3);
+
+	parent.removeBonus(bonus);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 1);
+
+	child.detachFrom(&parent);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 0);
+	child.attachTo(&parent);
+}
+
+TEST_F(CBonusSystemNodeTest, CachedRequestIsRefreshedAfterDurationReduced)
+{
+	const auto cachingKey = BonusCacheKey::typeTurns(Bonus::STACKS_SPEED, 2);
+	auto selector = Selector::type(Bonus::STACKS_SPEED).And(Selector::turns(2));
+
+	auto bonus = std::make_shared<Bonus>(Bonus::N_TURNS, Bonus::STACKS_SPEED, Bonus::OTHER, 2, 0);
+	bonus->turnsRemain = 3;
+	parent.addNewBonus(bonus);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 2);
+
+	parent.reduceBonusDurations(Bonus::NTurns);
+	EXPECT_EQ(bonus->turnsRemain, 2);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 0);
+}
+
+TEST_F(CBonusSystemNodeTest, CachedRequestIsRefreshedAfterBonusAccumulated)
+{
+	const auto cachingKey = BonusCacheKey::type(Bonus::STACKS_SPEED);
+	auto selector = Selector::type(Bonus::STACKS_SPEED);
+
+	parent.accumulateBonus(makeBonus(Bonus::STACKS_SPEED, 1));
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 1);
+
+	parent.accumulateBonus(makeBonus(Bonus::STACKS_SPEED, 2));
+	EXPECT_EQ(parent.getExportedBonusList().size(), 1);
+	EXPECT_EQ(child.valOfBonuses(selector, cachingKey), 3);
+}
+
+TEST_F(CBonusSystemNodeTest, GlobalChangeInvalidatesAllNodes)
+{
+	const int64_t childVersion = child.getTreeVersion();
+	const int64_t unrelatedVersion = unrelated.getTreeVersion();
+
+	CBonusSystemNode::treeHasChanged();
+
+	EXPECT_NE(child.getTreeVersion(), childVersion);
+	EXPECT_NE(unrelated.getTreeVersion(), unrelatedVersion);
+}
+
+TEST(BonusCacheKeyTest, KeysAreDistinct)
+{
+	EXPECT_TRUE(BonusCacheKey().empty());
+	EXPECT_TRUE(BonusCacheKey("").empty());
+
+	EXPECT_EQ(BonusCacheKey("type_STACKS_SPEED"), BonusCacheKey(std::string("type_STACKS_SPEED")));
+	EXPECT_FALSE(BonusCacheKey("type_STACKS_SPEED") == BonusCacheKey("type_STACK_HEALTH"));
+
+	EXPECT_EQ(BonusCacheKey::type(Bonus::STACKS_SPEED), BonusCacheKey::type(Bonus::STACKS_SPEED, -1));
+	EXPECT_FALSE(BonusCacheKey::type(Bonus::PRIMARY_SKILL, 0) == BonusCacheKey::type(Bonus::PRIMARY_SKILL, 1));
+	EXPECT_FALSE(BonusCacheKey::type(Bonus::PRIMARY_SKILL, 0) == BonusCacheKey::typeInfo(Bonus::PRIMARY_SKILL, 0, 0));
+	EXPECT_FALSE(BonusCacheKey::typeTurns(Bonus::STACKS_SPEED, 1) == BonusCacheKey::days(1));
+}
+
+TEST(CSelectorTest, TypeHints)
+{
+	EXPECT_EQ(Selector::all.getTypeHint(), CSelector::NO_HINT);
+
+	auto typed = Selector::type(Bonus::PRIMARY_SKILL);
+	EXPECT_EQ(typed.getTypeHint(), Bonus::PRIMARY_SKILL);
+	EXPECT_EQ(typed.getSubtypeHint(), CSelector::NO_HINT);
+
+	auto subtyped = Selector::typeSubtype(Bonus::PRIMARY_SKILL, 2);
+	EXPECT_EQ(subtyped.getTypeHint(), Bonus::PRIMARY_SKILL);
+	EXPECT_EQ(subtyped.getSubtypeHint(), 2);
+
+	EXPECT_EQ(Selector::all.And(subtyped).getSubtypeHint(), 2);
+	EXPECT_EQ(subtyped.And(typed).getSubtypeHint(), 2);
+	EXPECT_EQ(subtyped.And(Selector::turns(1)).getSubtypeHint(), 2);
+
+	EXPECT_EQ(typed.Or(subtyped).getTypeHint(), Bonus::PRIMARY_SKILL);
+	EXPECT_EQ(typed.Or(subtyped).getSubtypeHint(), CSelector::NO_HINT);
+	EXPECT_EQ(typed.Or(Selector::type(Bonus::LUCK)).getTypeHint(), CSelector::NO_HINT);
+	EXPECT_EQ(typed.Or(Selector::all).getTypeHint(), CSelector::NO_HINT);
+}
+
+TEST_F(CBonusSystemNodeTest, TypedQueriesUseIndex)
+{
+	for(int i = 0; i < 4; i++)
+	{
+		parent.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 1 << i, i, i % 2));
+		child.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::STACKS_SPEED, Bonus::OTHER, 1, i, i));
+	}
+
+	EXPECT_EQ(child.valOfBonuses(Selector::type(Bonus::PRIMARY_SKILL)), 15);
+	EXPECT_EQ(child.valOfBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, 0)), 5);
+	EXPECT_EQ(child.valOfBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, 1)), 10);
+	EXPECT_EQ(child.valOfBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, 2)), 0);
+	EXPECT_EQ(child.valOfBonuses(Selector::typeSubtype(Bonus::PRIMARY_SKILL, 1).And(Selector::source(Bonus::OTHER, 3))), 8);
+	EXPECT_EQ(child.valOfBonuses(Selector::type(Bonus::STACKS_SPEED).Or(Selector::type(Bonus::PRIMARY_SKILL))), 19);
+	EXPECT_EQ(child.valOfBonuses(Selector::type(Bonus::LUCK)), 0);
+	EXPECT_EQ(child.getBonuses(Selector::type(Bonus::STACKS_SPEED))->size(), 4);
+}
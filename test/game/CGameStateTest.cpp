@@ -9,12 +9,14 @@
  */
 #include "StdInc.h"
 
-#include "mock/mock_MapService.h"
-#include "mock/mock_IGameCallback.h"
+#include "GameStateFixture.h"
 
 #include "../../lib/VCMIDirs.h"
+#include "../../lib/CConfigHandler.h"
 #include "../../lib/CGameState.h"
+#include "../../lib/CPlayerState.h"
 #include "../../lib/NetPacks.h"
+#include "../../lib/ScopeGuard.h"
 #include "../../lib/StartInfo.h"
 
 #include "../../lib/battle/BattleInfo.h"
@@ -28,111 +30,9 @@
 #include "../../lib/spells/ISpellMechanics.h"
 #include "../../lib/spells/AbilityCaster.h"
 
-class CGameStateTest : public ::testing::Test, public SpellCastEnvironment, public MapListener
+class CGameStateTest : public ::testing::Test, public test::GameStateFixture
 {
 public:
-	CGameStateTest()
-		: gameCallback(new GameCallbackMock(this)),
-		mapService("test/MiniTest/", this),
-		map(nullptr)
-	{
-		IObjectInterface::cb = gameCallback.get();
-	}
-
-	virtual ~CGameStateTest()
-	{
-		IObjectInterface::cb = nullptr;
-	}
-
-	void sendAndApply(CPackForClient * pack) const override
-	{
-		gameState->apply(pack);
-	}
-
-	void complain(const std::string & problem) const
-	{
-		FAIL() << "Server-side assertion:" << problem;
-	};
-
-	CRandomGenerator & getRandomGenerator() const override
-	{
-		return gameState->getRandomGenerator();//todo: mock this
-	}
-
-	const CMap * getMap() const override
-	{
-		return map;
-	}
-	const CGameInfoCallback * getCb() const override
-	{
-		return gameState.get();
-	}
-
-	bool moveHero(ObjectInstanceID hid, int3 dst, bool teleporting) const override
-	{
-		return false;
-	}
-
-	void genericQuery(Query * request, PlayerColor color, std::function<void(const JsonNode &)> callback) const
-	{
-		//todo:
-	}
-
-	void mapLoaded(CMap * map) override
-	{
-		EXPECT_EQ(this->map, nullptr);
-		this->map = map;
-	}
-
-	void startTestGame()
-	{
-		StartInfo si;
-		si.mapname = "anything";//does not matter, map service mocked
-		si.difficulty = 0;
-		si.mapfileChecksum = 0;
-		si.mode = StartInfo::NEW_GAME;
-		si.seedToBeUsed = 42;
-
-		std::unique_ptr<CMapHeader> header = mapService.loadMapHeader(ResourceID(si.mapname));
-
-		ASSERT_NE(header.get(), nullptr);
-
-		//FIXME: this has been copied from CPreGame, but should be part of StartInfo
-		for(int i = 0; i < header->players.size(); i++)
-		{
-			const PlayerInfo & pinfo = header->players[i];
-
-			//neither computer nor human can play - no player
-			if (!(pinfo.canHumanPlay || pinfo.canComputerPlay))
-				continue;
-
-			PlayerSettings & pset = si.playerInfos[PlayerColor(i)];
-			pset.color = PlayerColor(i);
-			pset.connectedPlayerIDs.insert(i);
-			pset.name = "Player";
-
-			pset.castle = pinfo.defaultCastle();
-			pset.hero = pinfo.defaultHero();
-
-			if(pset.hero != PlayerSettings::RANDOM && pinfo.hasCustomMainHero())
-			{
-				pset.hero = pinfo.mainCustomHeroId;
-				pset.heroName = pinfo.mainCustomHeroName;
-				pset.heroPortrait = pinfo.mainCustomHeroPortrait;
-			}
-
-			pset.handicap = PlayerSettings::NO_HANDICAP;
-		}
-
-		gameState = std::make_shared<CGameState>();
-		gameCallback->setGameState(gameState.get());
-		gameState->init(&mapService, &si, false);
-
-		ASSERT_NE(map, nullptr);
-		ASSERT_EQ(map->heroesOnMap.size(), 2);
-	}
-
-
 	void startTestBattle(const CGHeroInstance * attacker, const CGHeroInstance * defender)
 	{
 		const CGHeroInstance * heroes[2] = {attacker, defender};
@@ -156,13 +56,31 @@ public:
 		ASSERT_EQ(gameState->curB, battle);
 	}
 
-	std::shared_ptr<CGameState> gameState;
-
-	std::shared_ptr<GameCallbackMock> gameCallback;
+	void checkPaths(const CGHeroInstance * hero, const CPathsInfo & actual)
+	{
+		CPathsInfo expected(actual.sizes);
+		gameState->calculatePaths(hero, expected);
 
-	MapServiceMock mapService;
+		EXPECT_EQ(actual.hpos, expected.hpos);
 
-	CMap * map;
+		int3 pos;
+		for(pos.x = 0; pos.x < expected.sizes.x; pos.x++)
+		{
+			for(pos.y = 0; pos.y < expected.sizes.y; pos.y++)
+			{
+				for(pos.z = 0; pos.z < expected.sizes.z; pos.z++)
+				{
+					const CGPathNode * expectedNode = expected.getPathInfo(pos);
+					const CGPathNode * actualNode = actual.getPathInfo(pos);
+
+					EXPECT_EQ(actualNode->accessible, expectedNode->accessible) << pos.toString();
+					EXPECT_EQ(actualNode->turns, expectedNode->turns) << pos.toString();
+					EXPECT_EQ(actualNode->moveRemains, expectedNode->moveRemains) << pos.toString();
+					EXPECT_EQ(actualNode->action, expectedNode->action) << pos.toString();
+				}
+			}
+		}
+	}
 };
 
 //Issue #2765, Ghost Dragons can cast Age on Catapults
@@ -331,3 +249,131 @@ TEST_F(CGameStateTest, battleResurrection)
 	EXPECT_EQ(unit->health.getCount(), 10);
 	EXPECT_EQ(unit->health.getResurrected(), 0);
 }
+
+TEST_F(CGameStateTest, batchPathsMatchSingleHeroPaths)
+{
+	startTestGame();
+
+	for(const CGHeroInstance * hero : map->heroesOnMap)
+	{
+		std::map<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> batch;
+		gameState->calculatePaths(hero->tempOwner, batch);
+
+		ASSERT_TRUE(vstd::contains(batch, hero));
+		EXPECT_EQ(batch.at(hero)->hero, hero);
+
+		checkPaths(hero, *batch.at(hero));
+	}
+}
+
+TEST_F(CGameStateTest, updatedPathsMatchFullRecalculation)
+{
+	startTestGame();
+
+	const CGHeroInstance * hero = map->heroesOnMap[0];
+	const int3 hpos = hero->getPosition(false);
+
+	CPathsInfo paths(int3(map->width, map->height, map->twoLevel ? 2 : 1));
+	gameState->calculatePaths(hero, paths);
+
+	auto & fow = gameState->getPlayerTeam(hero->tempOwner)->fogOfWarMap;
+
+	//hide a wall of tiles in front of hero so paths have to go around it
+	std::map<int3, bool> hiddenTiles;
+	for(int3 tile(hpos.x - 2, hpos.y + 2, hpos.z); tile.x <= hpos.x + 2; tile.x++)
+	{
+		if(!map->isInTheMap(tile))
+			continue;
+
+		hiddenTiles[tile] = fow.isVisible(tile);
+		fow.setVisible(tile, false);
+	}
+	ASSERT_FALSE(hiddenTiles.empty());
+
+	gameState->updatePaths(hero, paths);
+	EXPECT_EQ(paths.incrementalUpdates, 1u);
+	checkPaths(hero, paths);
+
+	//and reveal them again so paths through them become shorter
+	for(auto & tile : hiddenTiles)
+		fow.setVisible(tile.first, tile.second);
+
+	gameState->updatePaths(hero, paths);
+	EXPECT_EQ(paths.incrementalUpdates, 2u);
+	checkPaths(hero, paths);
+}
+
+TEST_F(CGameStateTest, updatedPathsFollowMovedHero)
+{
+	startTestGame();
+
+	const CGHeroInstance * hero = map->heroesOnMap[0];
+
+	CPathsInfo paths(int3(map->width, map->height, map->twoLevel ? 2 : 1));
+	gameState->calculatePaths(hero, paths);
+
+	//longest path hero can walk this turn
+	CGPath path;
+	int3 pos;
+	for(pos.x = 0; pos.x < paths.sizes.x; pos.x++)
+	{
+		for(pos.y = 0; pos.y < paths.sizes.y; pos.y++)
+		{
+			for(pos.z = 0; pos.z < paths.sizes.z; pos.z++)
+			{
+				const CGPathNode * node = paths.getPathInfo(pos);
+				CGPath candidate;
+				if(node->turns == 0 && node->action == CGPathNode::NORMAL && paths.getPath(candidate, pos) && candidate.nodes.size() > path.nodes.size())
+					path = candidate;
+			}
+		}
+	}
+	ASSERT_GE(path.nodes.size(), 3);
+
+	//first node of path is its destination, last one is current hero position
+	for(int i = static_cast<int>(path.nodes.size()) - 2; i >= 0; i--)
+	{
+		const CGPathNode & step = path.nodes[i];
+
+		TryMoveHero tmh;
+		tmh.id = hero->id;
+		tmh.result = TryMoveHero::SUCCESS;
+		tmh.start = hero->getPosition(true);
+		tmh.end = CGHeroInstance::convertPosition(step.coord, true);
+		tmh.movePoints = step.moveRemains;
+		gameState->getTilesInRange(tmh.fowRevealed, step.coord, hero->getSightRadius(), hero->tempOwner, 1);
+		gameCallback->sendAndApply(&tmh);
+
+		ASSERT_EQ(hero->getPosition(false), step.coord);
+
+		const ui32 incrementalUpdates = paths.incrementalUpdates;
+		gameState->updatePaths(hero, paths);
+		EXPECT_EQ(paths.incrementalUpdates, incrementalUpdates + 1);
+		checkPaths(hero, paths);
+	}
+}
+
+TEST_F(CGameStateTest, bucketQueuePathsMatchHeapPaths)
+{
+	startTestGame();
+
+	const bool useBucketQueue = settings["pathfinder"]["bucketQueue"].Bool();
+	auto setBucketQueue = [](bool value)
+	{
+		Settings bucketQueue = settings.write["pathfinder"]["bucketQueue"];
+		bucketQueue->Bool() = value;
+	};
+	auto guard = vstd::makeScopeGuard([&]()
+	{
+		setBucketQueue(useBucketQueue);
+	});
+
+	for(const CGHeroInstance * hero : map->heroesOnMap)
+	{
+		CPathsInfo paths(int3(map->width, map->height, map->twoLevel ? 2 : 1));
+		setBucketQueue(false);
+		gameState->calculatePaths(hero, paths);
+		setBucketQueue(true);
+		checkPaths(hero, paths);
+	}
+}
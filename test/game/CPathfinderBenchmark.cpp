@@ -0,0 +1,102 @@
+/*
+ * CPathfinderBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "GameStateFixture.h"
+
+#include "../../lib/CConfigHandler.h"
+#include "../../lib/CGameState.h"
+#include "../../lib/CPathfinder.h"
+#include "../../lib/StartInfo.h"
+
+#include "../../lib/mapping/CMap.h"
+#include "../../lib/mapObjects/CGHeroInstance.h"
+#include "../../lib/rmg/CMapGenOptions.h"
+
+class CPathfinderBenchmark : public ::testing::Test, public test::GameStateFixture
+{
+public:
+	virtual ~CPathfinderBenchmark()
+	{
+		setBucketQueue(true);
+	}
+
+	void startRandomGame(int size)
+	{
+		StartInfo si;
+		si.mode = StartInfo::NEW_GAME;
+		si.difficulty = 0;
+		si.seedToBeUsed = 42;
+		si.mapGenOptions = std::make_shared<CMapGenOptions>();
+		si.mapGenOptions->setWidth(size);
+		si.mapGenOptions->setHeight(size);
+		si.mapGenOptions->setHasTwoLevels(true);
+		si.mapGenOptions->setPlayerCount(2);
+
+		gameState = std::make_shared<CGameState>();
+		gameCallback->setGameState(gameState.get());
+		gameState->init(nullptr, &si, false);
+
+		//generated map does not come from map service
+		map = gameState->map;
+		ASSERT_NE(map, nullptr);
+		ASSERT_FALSE(map->heroesOnMap.empty());
+	}
+
+	int3 mapSizes() const
+	{
+		return int3(gameState->map->width, gameState->map->height, gameState->map->twoLevel ? 2 : 1);
+	}
+
+	void setBucketQueue(bool value)
+	{
+		Settings bucketQueue = settings.write["pathfinder"]["bucketQueue"];
+		bucketQueue->Bool() = value;
+	}
+
+	/// Times full-map searches for every hero on the map with both open set implementations
+	void benchmarkSearches(int searches)
+	{
+		const int3 sizes = mapSizes();
+		const size_t allLayersSize = sizes.x * sizes.y * sizes.z * EPathfindingLayer::NUM_LAYERS * sizeof(CGPathNode);
+
+		for(const CGHeroInstance * hero : gameState->map->heroesOnMap)
+		{
+			for(bool bucketQueue : {false, true})
+			{
+				setBucketQueue(bucketQueue);
+
+				CPathsInfo paths(sizes);
+
+				auto start = std::chrono::steady_clock::now();
+				for(int i = 0; i < searches; i++)
+					gameState->calculatePaths(hero, paths);
+
+				const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+				std::cout << boost::format("%s (%s): %.3f ms per search, nodes take %d KB (%d KB with all layers, %d bytes per node)")
+					% hero->name % (bucketQueue ? "bucket queue" : "binary heap") % (milliseconds / searches)
+					% (paths.getMemoryUsage() / 1024) % (allLayersSize / 1024) % sizeof(CGPathNode) << std::endl;
+			}
+		}
+	}
+};
+
+TEST_F(CPathfinderBenchmark, DISABLED_TestMap)
+{
+	startTestGame();
+	benchmarkSearches(1000);
+}
+
+TEST_F(CPathfinderBenchmark, DISABLED_XLargeMap)
+{
+	startRandomGame(CMapHeader::MAP_SIZE_XLARGE);
+	benchmarkSearches(20);
+}
@@ -0,0 +1,126 @@
+/*
+ * GameStateFixture.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "GameStateFixture.h"
+
+#include "../../lib/CGameState.h"
+#include "../../lib/StartInfo.h"
+
+#include "../../lib/filesystem/ResourceID.h"
+
+#include "../../lib/mapping/CMap.h"
+
+namespace test
+{
+
+GameStateFixture::GameStateFixture()
+	: gameCallback(new GameCallbackMock(this)),
+	mapService("test/MiniTest/", this),
+	map(nullptr)
+{
+	IObjectInterface::cb = gameCallback.get();
+}
+
+GameStateFixture::~GameStateFixture()
+{
+	IObjectInterface::cb = nullptr;
+}
+
+void GameStateFixture::sendAndApply(CPackForClient * pack) const
+{
+	gameState->apply(pack);
+}
+
+void GameStateFixture::complain(const std::string & problem) const
+{
+	FAIL() << "Server-side assertion:" << problem;
+}
+
+CRandomGenerator & GameStateFixture::getRandomGenerator() const
+{
+	return gameState->getRandomGenerator();//todo: mock this
+}
+
+const CMap * GameStateFixture::getMap() const
+{
+	return map;
+}
+
+const CGameInfoCallback * GameStateFixture::getCb() const
+{
+	return gameState.get();
+}
+
+bool GameStateFixture::moveHero(ObjectInstanceID hid, int3 dst, bool teleporting) const
+{
+	return false;
+}
+
+void GameStateFixture::genericQuery(Query * request, PlayerColor color, std::function<void(const JsonNode &)> callback) const
+{
+	//todo:
+}
+
+void GameStateFixture::mapLoaded(CMap * map)
+{
+	EXPECT_EQ(this->map, nullptr);
+	this->map = map;
+}
+
+void GameStateFixture::startTestGame()
+{
+	StartInfo si;
+	si.mapname = "anything";//does not matter, map service mocked
+	si.difficulty = 0;
+	si.mapfileChecksum = 0;
+	si.mode = StartInfo::NEW_GAME;
+	si.seedToBeUsed = 42;
+
+	std::unique_ptr<CMapHeader> header = mapService.loadMapHeader(ResourceID(si.mapname));
+
+	ASSERT_NE(header.get(), nullptr);
+
+	//FIXME: this has been copied from CPreGame, but should be part of StartInfo
+	for(int i = 0; i < static_cast<int>(header->players.size()); i++)
+	{
+		const PlayerInfo & pinfo = header->players[i];
+
+		//neither computer nor human can play - no player
+		if (!(pinfo.canHumanPlay || pinfo.canComputerPlay))
+			continue;
+
+		PlayerSettings & pset = si.playerInfos[PlayerColor(i)];
+		pset.color = PlayerColor(i);
+		pset.connectedPlayerIDs.insert(i);
+		pset.name = "Player";
+
+		pset.castle = pinfo.defaultCastle();
+		pset.hero = pinfo.defaultHero();
+
+		if(pset.hero != PlayerSettings::RANDOM && pinfo.hasCustomMainHero())
+		{
+			pset.hero = pinfo.mainCustomHeroId;
+			pset.heroName = pinfo.mainCustomHeroName;
+			pset.heroPortrait = pinfo.mainCustomHeroPortrait;
+		}
+
+		pset.handicap = PlayerSettings::NO_HANDICAP;
+	}
+
+	gameState = std::make_shared<CGameState>();
+	gameCallback->setGameState(gameState.get());
+	gameState->init(&mapService, &si, false);
+
+	ASSERT_NE(map, nullptr);
+	ASSERT_EQ(map->heroesOnMap.size(), 2);
+}
+
+}
@@ -0,0 +1,54 @@
+/*
+ * GameStateFixture.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#pragma once
+
+#include "mock/mock_MapService.h"
+#include "mock/mock_IGameCallback.h"
+
+#include "../../lib/spells/ISpellMechanics.h"
+
+class CGameState;
+class CMap;
+
+namespace test
+{
+
+/// Game state started on test map with mocked server, packs are applied directly to game state
+class GameStateFixture : public SpellCastEnvironment, public MapListener
+{
+public:
+	GameStateFixture();
+	virtual ~GameStateFixture();
+
+	void sendAndApply(CPackForClient * pack) const override;
+	void complain(const std::string & problem) const override;
+
+	CRandomGenerator & getRandomGenerator() const override;
+	const CMap * getMap() const override;
+	const CGameInfoCallback * getCb() const override;
+	bool moveHero(ObjectInstanceID hid, int3 dst, bool teleporting) const override;
+	void genericQuery(Query * request, PlayerColor color, std::function<void(const JsonNode &)> callback) const override;
+
+	void mapLoaded(CMap * map) override;
+
+	/// Starts new game on test map with all players that can play it
+	void startTestGame();
+
+	std::shared_ptr<CGameState> gameState;
+
+	std::shared_ptr<GameCallbackMock> gameCallback;
+
+	MapServiceMock mapService;
+
+	CMap * map;
+};
+
+}
@@ -0,0 +1,226 @@
+/*
+ * SaveLoadBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include <boost/core/demangle.hpp>
+
+#include "../../lib/IGameCallback.h"
+#include "../../lib/CGameState.h"
+#include "../../lib/ScopeGuard.h"
+#include "../../lib/serializer/BinaryDeserializer.h"
+#include "../../lib/serializer/LoadProfiler.h"
+
+// Savegame is taken from VCMI_BENCHMARK_SAVE environment variable: full path to .vcgm1 or .vsgm1 file,
+// it must be made with mods that are currently enabled. VCMI_BENCHMARK_ROUNDS sets number of loads.
+
+namespace
+{
+	std::atomic<size_t> allocationsCount(0);
+	std::atomic<size_t> allocatedBytes(0);
+}
+
+// Counts allocations of whole executable, which is why this benchmark is not part of vcmitest.
+// If vcmi library has its own allocator (as dll on Windows), its allocations are not visible here
+void * operator new(std::size_t size)
+{
+	allocationsCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	if(void * result = std::malloc(size ? size : 1))
+		return result;
+	throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace
+{
+	typedef std::chrono::steady_clock TClock;
+
+	double millisecondsSince(TClock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(TClock::now() - start).count();
+	}
+
+	/// Loads lib part of savegame, same as client and server do
+	class SaveLoader : public CPrivilegedInfoCallback
+	{
+	public:
+		~SaveLoader()
+		{
+			vstd::clear_pointer(gs);
+		}
+
+		/// Handlers from save replace current ones without freeing them, as they do in game
+		void load(const boost::filesystem::path & fname)
+		{
+			vstd::clear_pointer(gs);
+			CLoadFile file(fname, MINIMAL_SERIALIZATION_VERSION);
+			loadCommonState(file);
+		}
+	};
+
+	/// Time and allocations spent in each type of loaded object, self values exclude nested sections
+	class SectionStatistics : public ILoadProfiler
+	{
+	public:
+		SectionStatistics()
+		{
+			stack.reserve(256);
+		}
+
+		void sectionStarted(const char * name) override
+		{
+			Frame frame;
+			frame.name = name;
+			frame.allocations = allocationsCount;
+			frame.bytes = allocatedBytes;
+			frame.start = TClock::now();
+			stack.push_back(frame);
+		}
+
+		void sectionFinished() override
+		{
+			const Frame frame = stack.back();
+			stack.pop_back();
+
+			const double time = millisecondsSince(frame.start);
+			const size_t allocations = allocationsCount - frame.allocations;
+			const size_t bytes = allocatedBytes - frame.bytes;
+
+			//keyed by pointer so that lookup does not allocate, same names are merged in report
+			Totals & totals = sections[frame.name];
+			totals.count++;
+			totals.time += time;
+			totals.selfTime += time - frame.childTime;
+			totals.selfAllocations += allocations - frame.childAllocations;
+			totals.selfBytes += bytes - frame.childBytes;
+
+			if(!stack.empty())
+			{
+				stack.back().childTime += time;
+				stack.back().childAllocations += allocations;
+				stack.back().childBytes += bytes;
+			}
+		}
+
+		void print(std::ostream & out, size_t maxLines) const
+		{
+			std::map<std::string, Totals> merged;
+			double profiledTime = 0;
+			for(const auto & section : sections)
+			{
+				Totals & totals = merged[boost::core::demangle(section.first)];
+				totals.count += section.second.count;
+				totals.time += section.second.time;
+				totals.selfTime += section.second.selfTime;
+				totals.selfAllocations += section.second.selfAllocations;
+				totals.selfBytes += section.second.selfBytes;
+				profiledTime += section.second.selfTime;
+			}
+
+			std::vector<std::pair<std::string, Totals>> sorted(merged.begin(), merged.end());
+			boost::sort(sorted, [](const std::pair<std::string, Totals> & a, const std::pair<std::string, Totals> & b)
+			{
+				return a.second.selfTime > b.second.selfTime;
+			});
+
+			//total time of recursive types includes their nested instances more than once
+			out << boost::format("%-60s %8s %10s %7s %10s %12s %10s") % "Section" % "Count" % "Self ms" % "Self %" % "Total ms" % "Self allocs" % "Self KB" << std::endl;
+			for(size_t i = 0; i < sorted.size() && i < maxLines; i++)
+			{
+				const Totals & totals = sorted[i].second;
+				out << boost::format("%-60s %8d %10.2f %7.1f %10.2f %12d %10.1f")
+					% sorted[i].first.substr(0, 60) % totals.count % totals.selfTime % (100 * totals.selfTime / profiledTime)
+					% totals.time % totals.selfAllocations % (totals.selfBytes / 1024.0) << std::endl;
+			}
+		}
+
+	private:
+		struct Frame
+		{
+			const char * name = nullptr;
+			TClock::time_point start;
+			size_t allocations = 0;
+			size_t bytes = 0;
+			double childTime = 0;
+			size_t childAllocations = 0;
+			size_t childBytes = 0;
+		};
+
+		struct Totals
+		{
+			size_t count = 0;
+			double time = 0;
+			double selfTime = 0;
+			size_t selfAllocations = 0;
+			size_t selfBytes = 0;
+		};
+
+		std::vector<Frame> stack;
+		std::map<const char *, Totals> sections;
+	};
+}
+
+TEST(SaveLoadBenchmark, DISABLED_LoadSave)
+{
+	const char * saveName = std::getenv("VCMI_BENCHMARK_SAVE");
+	ASSERT_TRUE(saveName != nullptr) << "Set VCMI_BENCHMARK_SAVE to path of savegame";
+
+	const char * roundsValue = std::getenv("VCMI_BENCHMARK_ROUNDS");
+	const int rounds = roundsValue ? std::max(std::atoi(roundsValue), 1) : 5;
+
+	const boost::filesystem::path saveFile(saveName);
+	SaveLoader loader;
+
+	//warms up file cache and lazily initialized data
+	loader.load(saveFile);
+
+	double totalTime = 0;
+	double bestTime = std::numeric_limits<double>::max();
+	const size_t allocationsBefore = allocationsCount;
+	const size_t bytesBefore = allocatedBytes;
+
+	for(int i = 0; i < rounds; i++)
+	{
+		const auto start = TClock::now();
+		loader.load(saveFile);
+		const double time = millisecondsSince(start);
+
+		totalTime += time;
+		vstd::amin(bestTime, time);
+	}
+
+	std::cout << boost::format("Loaded %s %d times: %.1f ms average, %.1f ms best, %d allocations and %.1f MB allocated per load")
+		% saveFile.filename().string() % rounds % (totalTime / rounds) % bestTime
+		% ((allocationsCount - allocationsBefore) / rounds) % ((allocatedBytes - bytesBefore) / rounds / 1048576.0) << std::endl;
+
+	//separate round, so profiling overhead does not affect times above
+	SectionStatistics statistics;
+	{
+		ILoadProfiler::set(&statistics);
+		auto guard = vstd::makeScopeGuard([]()
+		{
+			ILoadProfiler::set(nullptr);
+		});
+		loader.load(saveFile);
+	}
+
+	std::cout << "Breakdown by loaded type:" << std::endl;
+	statistics.print(std::cout, 40);
+}
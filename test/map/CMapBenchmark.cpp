@@ -0,0 +1,132 @@
+/*
+ * CMapBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/mapping/CMap.h"
+
+namespace
+{
+	/// Tiles allocated the way CMap kept them before, one array per map column
+	class NestedTerrain : public boost::noncopyable
+	{
+	public:
+		NestedTerrain(const CMap & map)
+			: width(map.width), height(map.height)
+		{
+			const int levels = map.twoLevel ? 2 : 1;
+			tiles = new TerrainTile**[width];
+			for(int x = 0; x < width; x++)
+			{
+				tiles[x] = new TerrainTile*[height];
+				for(int y = 0; y < height; y++)
+				{
+					tiles[x][y] = new TerrainTile[levels];
+					for(int z = 0; z < levels; z++)
+						tiles[x][y][z] = map.getTile(int3(x, y, z));
+				}
+			}
+		}
+
+		~NestedTerrain()
+		{
+			for(int x = 0; x < width; x++)
+			{
+				for(int y = 0; y < height; y++)
+					delete [] tiles[x][y];
+				delete [] tiles[x];
+			}
+			delete [] tiles;
+		}
+
+		const TerrainTile & getTile(const int3 & tile) const
+		{
+			return tiles[tile.x][tile.y][tile.z];
+		}
+
+	private:
+		int width, height;
+		TerrainTile *** tiles;
+	};
+
+	std::unique_ptr<CMap> makeXLargeMap()
+	{
+		auto map = make_unique<CMap>();
+		map->width = CMapHeader::MAP_SIZE_XLARGE;
+		map->height = CMapHeader::MAP_SIZE_XLARGE;
+		map->twoLevel = true;
+		map->initTerrain();
+
+		for(int z = 0; z < 2; z++)
+		{
+			for(int y = 0; y < map->height; y++)
+			{
+				for(int x = 0; x < map->width; x++)
+				{
+					TerrainTile & tile = map->getTile(int3(x, y, z));
+					tile.terType = ETerrainType((x * 7 + y * 3 + z) % ETerrainType::ROCK);
+					tile.blocked = (x + y) % 5 == 0;
+				}
+			}
+		}
+		map->calculateGuardingGreaturePositions();
+		return map;
+	}
+
+	/// Visits every tile row by row like renderer or fog of war updates do, returns tiles per second
+	template<typename TileGetter>
+	double scanTiles(const CMap & map, int scans, const TileGetter & getTile)
+	{
+		const int levels = map.twoLevel ? 2 : 1;
+		size_t passable = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < scans; i++)
+		{
+			for(int z = 0; z < levels; z++)
+			{
+				for(int y = 0; y < map.height; y++)
+				{
+					for(int x = 0; x < map.width; x++)
+					{
+						const TerrainTile & tile = getTile(int3(x, y, z));
+						if(!tile.blocked && tile.terType != ETerrainType::WATER)
+							passable++;
+					}
+				}
+			}
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		EXPECT_GT(passable, 0);
+		return static_cast<double>(map.width) * map.height * levels * scans / seconds;
+	}
+}
+
+TEST(CMapBenchmark, DISABLED_XLargeTwoLevelTileScan)
+{
+	const int scans = 500;
+
+	auto map = makeXLargeMap();
+	NestedTerrain nested(*map);
+
+	const double nestedSpeed = scanTiles(*map, scans, [&](const int3 & pos) -> const TerrainTile &
+	{
+		return nested.getTile(pos);
+	});
+
+	const CMap & flat = *map;
+	const double flatSpeed = scanTiles(*map, scans, [&](const int3 & pos) -> const TerrainTile &
+	{
+		return flat.getTile(pos);
+	});
+
+	std::cout << boost::format("Tile scan: %.1f Mtiles/s nested arrays, %.1f Mtiles/s flat array (%d bytes per tile)")
+		% (nestedSpeed / 1e6) % (flatSpeed / 1e6) % sizeof(TerrainTile) << std::endl;
+}
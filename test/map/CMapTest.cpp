@@ -0,0 +1,184 @@
+/*
+ * CMapTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/mapping/CMap.h"
+#include "../../lib/serializer/CSerializer.h"
+
+namespace
+{
+	/// Records order in which map hands its tiles to serializer, everything else is ignored
+	class TileOrderRecorder
+	{
+	public:
+		bool saving;
+		std::vector<const TerrainTile *> tiles;
+
+		explicit TileOrderRecorder(bool saving_)
+			: saving(saving_)
+		{
+		}
+
+		TileOrderRecorder & operator&(const TerrainTile & tile)
+		{
+			tiles.push_back(&tile);
+			return *this;
+		}
+
+		template<typename T>
+		TileOrderRecorder & operator&(const T &)
+		{
+			return *this;
+		}
+	};
+
+	std::unique_ptr<CMap> makeMap(int width, int height, bool twoLevel)
+	{
+		auto map = make_unique<CMap>();
+		map->width = width;
+		map->height = height;
+		map->twoLevel = twoLevel;
+		map->initTerrain();
+		return map;
+	}
+
+	/// Order of tiles in savegames, from the time terrain was kept as [x][y][z] array
+	std::vector<const TerrainTile *> columnMajorTiles(const CMap & map)
+	{
+		std::vector<const TerrainTile *> result;
+		for(int x = 0; x < map.width; x++)
+			for(int y = 0; y < map.height; y++)
+				for(int z = 0; z < (map.twoLevel ? 2 : 1); z++)
+					result.push_back(&map.getTile(int3(x, y, z)));
+		return result;
+	}
+}
+
+TEST(TileObjectsTest, emptyList)
+{
+	TileObjects objects;
+
+	EXPECT_TRUE(objects.empty());
+	EXPECT_EQ(objects.size(), 0);
+	EXPECT_TRUE(objects.begin() == objects.end());
+
+	int visited = 0;
+	for(auto object : objects)
+	{
+		UNUSED(object);
+		visited++;
+	}
+	EXPECT_EQ(visited, 0);
+
+	TileObjects copy(objects);
+	EXPECT_TRUE(copy.empty());
+	EXPECT_TRUE(copy.begin() == copy.end());
+}
+
+TEST(TileObjectsTest, keepsOrder)
+{
+	CGObjectInstance first, second;
+	TileObjects objects;
+	objects.push_back(&first);
+	objects.push_back(&second);
+
+	EXPECT_FALSE(objects.empty());
+	ASSERT_EQ(objects.size(), 2);
+	EXPECT_EQ(objects.front(), &first);
+	EXPECT_EQ(objects.back(), &second);
+	EXPECT_EQ(objects[1], &second);
+	EXPECT_EQ(std::vector<CGObjectInstance *>(objects.begin(), objects.end()), (std::vector<CGObjectInstance *>{&first, &second}));
+}
+
+TEST(TileObjectsTest, copyIsIndependent)
+{
+	CGObjectInstance first, second;
+	TileObjects objects;
+	objects.push_back(&first);
+
+	TileObjects copy(objects);
+	copy.push_back(&second);
+	EXPECT_EQ(objects.size(), 1);
+	EXPECT_EQ(copy.size(), 2);
+
+	TileObjects assigned;
+	assigned = copy;
+	assigned.remove(&first);
+	EXPECT_EQ(copy.size(), 2);
+	ASSERT_EQ(assigned.size(), 1);
+	EXPECT_EQ(assigned.front(), &second);
+
+	assigned = TileObjects();
+	EXPECT_TRUE(assigned.empty());
+	EXPECT_EQ(copy.size(), 2);
+}
+
+TEST(TileObjectsTest, removesFirstOccurrence)
+{
+	CGObjectInstance first, second, absent;
+	TileObjects objects;
+
+	EXPECT_FALSE(objects.remove(&first));
+
+	objects.push_back(&first);
+	objects.push_back(&second);
+	objects.push_back(&first);
+
+	EXPECT_FALSE(objects.remove(&absent));
+	EXPECT_EQ(objects.size(), 3);
+
+	EXPECT_TRUE(objects.remove(&first));
+	ASSERT_EQ(objects.size(), 2);
+	EXPECT_EQ(objects.front(), &second);
+	EXPECT_EQ(objects.back(), &first);
+
+	EXPECT_TRUE(objects.remove(&second));
+	EXPECT_TRUE(objects.remove(&first));
+	EXPECT_TRUE(objects.empty());
+	EXPECT_TRUE(objects.begin() == objects.end());
+	EXPECT_FALSE(objects.remove(&first));
+}
+
+TEST(CMapTest, tilesAreStoredRowAfterRow)
+{
+	auto map = makeMap(5, 3, true);
+
+	const TerrainTile * origin = &map->getTile(int3(0, 0, 0));
+	for(int z = 0; z < 2; z++)
+	{
+		for(int y = 0; y < map->height; y++)
+		{
+			for(int x = 0; x < map->width; x++)
+			{
+				const ptrdiff_t expected = (z * map->height + y) * map->width + x;
+				EXPECT_EQ(&map->getTile(int3(x, y, z)) - origin, expected) << int3(x, y, z).toString();
+			}
+		}
+	}
+}
+
+TEST(CMapTest, savesTilesInColumnOrder)
+{
+	auto map = makeMap(4, 3, true);
+
+	TileOrderRecorder saver(true);
+	map->serialize(saver, SERIALIZATION_VERSION);
+	EXPECT_EQ(saver.tiles, columnMajorTiles(*map));
+}
+
+TEST(CMapTest, loadsTilesInColumnOrder)
+{
+	auto map = makeMap(4, 3, false);
+
+	//loading allocates terrain anew, so expected addresses are taken afterwards
+	TileOrderRecorder loader(false);
+	map->serialize(loader, SERIALIZATION_VERSION);
+	EXPECT_EQ(loader.tiles, columnMajorTiles(*map));
+}
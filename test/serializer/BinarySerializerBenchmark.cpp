@@ -0,0 +1,153 @@
+/*
+ * BinarySerializerBenchmark.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/serializer/CMemorySerializer.h"
+
+namespace
+{
+	//below length that makes deserializer warn about suspicious data
+	const size_t VECTOR_LENGTH = 400000;
+	const int ROUNDS = 20;
+
+	template<typename Function>
+	double megabytesPerSecond(size_t bytes, const Function & function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < ROUNDS; i++)
+			function();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return bytes * ROUNDS / seconds / 1e6;
+	}
+
+	struct LinkedNode
+	{
+		si32 value = 0;
+		std::vector<LinkedNode *> links;
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & value;
+			h & links;
+		}
+	};
+
+	template<typename T>
+	void measureVector(const std::string & name, const std::vector<T> & data)
+	{
+		const size_t bytes = data.size() * sizeof(T);
+		std::vector<T> loaded;
+
+		const double bulkSave = megabytesPerSecond(bytes, [&]()
+		{
+			CMemorySerializer mem;
+			mem.oser & data;
+		});
+
+		const double bulkLoad = megabytesPerSecond(bytes, [&]()
+		{
+			CMemorySerializer mem;
+			mem.oser & data;
+			mem.iser & loaded;
+		});
+
+		//same format, element by element as it was done before bulk copy
+		const double elementSave = megabytesPerSecond(bytes, [&]()
+		{
+			CMemorySerializer mem;
+			mem.oser & static_cast<ui32>(data.size());
+			for(const T & element : data)
+				mem.oser & element;
+		});
+
+		const double elementLoad = megabytesPerSecond(bytes, [&]()
+		{
+			CMemorySerializer mem;
+			mem.oser & data;
+			ui32 length = 0;
+			mem.iser & length;
+			loaded.resize(length);
+			for(T & element : loaded)
+				mem.iser & element;
+		});
+
+		EXPECT_EQ(loaded, data);
+		std::cout << boost::format("%-8s bulk: save %8.1f MB/s, save+load %8.1f MB/s; per element: save %8.1f MB/s, save+load %8.1f MB/s")
+			% name % bulkSave % bulkLoad % elementSave % elementLoad << std::endl;
+	}
+}
+
+TEST(BinarySerializerBenchmark, DISABLED_VectorThroughput)
+{
+	std::vector<ui8> bytes(VECTOR_LENGTH);
+	std::vector<si32> numbers(VECTOR_LENGTH);
+	std::vector<int3> points(VECTOR_LENGTH);
+
+	for(size_t i = 0; i < VECTOR_LENGTH; i++)
+	{
+		bytes[i] = static_cast<ui8>(i);
+		numbers[i] = static_cast<si32>(i * 7);
+		points[i] = int3(static_cast<si32>(i % 144), static_cast<si32>(i / 144), 1);
+	}
+
+	measureVector("ui8", bytes);
+	measureVector("si32", numbers);
+	measureVector("int3", points);
+}
+
+TEST(BinarySerializerBenchmark, DISABLED_PointerGraph)
+{
+	//every node is referenced several times, like objects, artifacts and bonuses of game state
+	const size_t nodesCount = 200000;
+	const size_t linksPerNode = 4;
+
+	std::vector<std::unique_ptr<LinkedNode>> nodes;
+	std::vector<LinkedNode *> roots;
+	for(size_t i = 0; i < nodesCount; i++)
+	{
+		nodes.push_back(make_unique<LinkedNode>());
+		nodes.back()->value = static_cast<si32>(i);
+		roots.push_back(nodes.back().get());
+	}
+
+	//links go only to preceding nodes, so that serialization does not recurse deeply
+	std::mt19937 rand(42);
+	for(size_t i = 0; i < nodesCount; i++)
+	{
+		for(size_t j = 0; j < linksPerNode; j++)
+			nodes[i]->links.push_back(nodes[rand() % (i + 1)].get());
+	}
+
+	double saveTime = 0;
+	double loadTime = 0;
+	std::vector<LinkedNode *> loaded;
+
+	for(int i = 0; i < 5; i++)
+	{
+		CMemorySerializer mem;
+		auto start = std::chrono::steady_clock::now();
+		mem.oser & roots;
+		saveTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for(LinkedNode * node : loaded)
+			delete node;
+
+		start = std::chrono::steady_clock::now();
+		mem.iser & loaded;
+		loadTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	ASSERT_EQ(loaded.size(), nodesCount);
+	EXPECT_EQ(loaded[1]->links[0]->value, roots[1]->links[0]->value);
+	for(LinkedNode * node : loaded)
+		delete node;
+
+	std::cout << boost::format("%d nodes with %d links each: save %.1f ms, load %.1f ms") % nodesCount % linksPerNode % (saveTime / 5) % (loadTime / 5) << std::endl;
+}
@@ -0,0 +1,300 @@
+/*
+ * BinarySerializerTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/serializer/BinarySerializer.h"
+#include "../../lib/serializer/BinaryDeserializer.h"
+#include "../../lib/serializer/CTypeList.h"
+#include "../../lib/ScopeGuard.h"
+
+namespace
+{
+	/// Keeps written bytes accessible, unlike CMemorySerializer
+	class ByteBuffer : public IBinaryReader, public IBinaryWriter
+	{
+	public:
+		std::vector<ui8> bytes;
+		size_t readPos;
+
+		BinarySerializer saver;
+		BinaryDeserializer loader;
+
+		ByteBuffer()
+			: readPos(0), saver(this), loader(this)
+		{
+			loader.fileVersion = SERIALIZATION_VERSION;
+		}
+
+		int read(void * data, unsigned size) override
+		{
+			if(bytes.size() < readPos + size)
+				throw std::runtime_error("Cannot read past the buffer");
+			std::memcpy(data, bytes.data() + readPos, size);
+			readPos += size;
+			return size;
+		}
+
+		int write(const void * data, unsigned size) override
+		{
+			const ui8 * begin = static_cast<const ui8 *>(data);
+			bytes.insert(bytes.end(), begin, begin + size);
+			return size;
+		}
+	};
+
+	struct Node
+	{
+		si32 value = 0;
+		Node * next = nullptr;
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & value;
+			h & next;
+		}
+	};
+
+	struct Shape
+	{
+		si32 id = 0;
+
+		virtual ~Shape() = default;
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & id;
+		}
+	};
+
+	struct Square : public Shape
+	{
+		si32 side = 0;
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & static_cast<Shape &>(*this);
+			h & side;
+		}
+	};
+
+#ifndef _MSC_VER
+	/// Same type seen through another type_info object, as with types from dynamically loaded AI libraries
+	class TypeInfoCopy : public std::type_info
+	{
+	public:
+		explicit TypeInfoCopy(const char * name)
+			: std::type_info(name)
+		{
+		}
+	};
+#endif
+
+	template<typename T>
+	T swapBytes(T value)
+	{
+		char * begin = reinterpret_cast<char *>(&value);
+		std::reverse(begin, begin + sizeof(T));
+		return value;
+	}
+}
+
+TEST(BinarySerializerTest, roundTripsVectors)
+{
+	const std::vector<ui8> bytes = {0, 1, 255};
+	const std::vector<si32> numbers = {-1, 0, 1337};
+	const std::vector<double> floats = {-0.5, 1e100};
+	const std::vector<int3> points = {int3(1, 2, 3), int3(-70, 0, 1)};
+	const std::vector<std::string> strings = {"", "text"};
+	const std::vector<ui8> empty;
+
+	ByteBuffer buffer;
+	buffer.saver & bytes & numbers & floats & points & strings & empty;
+
+	std::vector<ui8> loadedBytes = {42};
+	std::vector<si32> loadedNumbers;
+	std::vector<double> loadedFloats;
+	std::vector<int3> loadedPoints;
+	std::vector<std::string> loadedStrings;
+	std::vector<ui8> loadedEmpty = {1, 2};
+	buffer.loader & loadedBytes & loadedNumbers & loadedFloats & loadedPoints & loadedStrings & loadedEmpty;
+
+	EXPECT_EQ(loadedBytes, bytes);
+	EXPECT_EQ(loadedNumbers, numbers);
+	EXPECT_EQ(loadedFloats, floats);
+	EXPECT_EQ(loadedPoints, points);
+	EXPECT_EQ(loadedStrings, strings);
+	EXPECT_TRUE(loadedEmpty.empty());
+	EXPECT_EQ(buffer.readPos, buffer.bytes.size());
+}
+
+TEST(BinarySerializerTest, bulkVectorsKeepElementFormat)
+{
+	const std::vector<int3> points = {int3(1, 2, 3), int3(-70, 0, 1)};
+	const std::vector<ui16> numbers = {1, 65535};
+
+	ByteBuffer bulk;
+	bulk.saver & points & numbers;
+
+	ByteBuffer elements;
+	elements.saver & static_cast<ui32>(points.size());
+	for(const int3 & point : points)
+		elements.saver & point;
+	elements.saver & static_cast<ui32>(numbers.size());
+	for(ui16 number : numbers)
+		elements.saver & number;
+
+	EXPECT_EQ(bulk.bytes, elements.bytes);
+}
+
+TEST(BinarySerializerTest, reversesFieldsOfOtherEndianness)
+{
+	ByteBuffer buffer;
+	buffer.saver & swapBytes<ui32>(2) & swapBytes<si32>(0x01020304) & swapBytes<si32>(-2);
+	buffer.saver & swapBytes<ui32>(1) & swapBytes<si32>(1) & swapBytes<si32>(-2) & swapBytes<si32>(300);
+	buffer.saver & swapBytes<ui32>(1) & swapBytes<ui16>(0x1234);
+
+	std::vector<si32> numbers;
+	std::vector<int3> points;
+	std::vector<ui16> shorts;
+	buffer.loader.reverseEndianess = true;
+	buffer.loader & numbers & points & shorts;
+
+	EXPECT_EQ(numbers, (std::vector<si32>{0x01020304, -2}));
+	EXPECT_EQ(points, std::vector<int3>{int3(1, -2, 300)});
+	EXPECT_EQ(shorts, std::vector<ui16>{0x1234});
+}
+
+TEST(BinarySerializerTest, restoresSharedPointers)
+{
+	Node first;
+	Node second;
+	first.value = 1;
+	first.next = &second;
+	second.value = 2;
+	second.next = &first;
+
+	ByteBuffer buffer;
+	buffer.saver & std::vector<Node *>{&first, &second, &first, nullptr};
+
+	std::vector<Node *> loaded;
+	buffer.loader & loaded;
+
+	ASSERT_EQ(loaded.size(), 4);
+	EXPECT_EQ(loaded[0]->value, 1);
+	EXPECT_EQ(loaded[1]->value, 2);
+	EXPECT_EQ(loaded[0]->next, loaded[1]);
+	EXPECT_EQ(loaded[1]->next, loaded[0]);
+	EXPECT_EQ(loaded[2], loaded[0]);
+	EXPECT_EQ(loaded[3], nullptr);
+	EXPECT_EQ(buffer.loader.loadedPointers.size(), 2);
+
+	delete loaded[0];
+	delete loaded[1];
+}
+
+TEST(BinarySerializerTest, restoresPolymorphicPointers)
+{
+	Square square;
+	square.id = 1;
+	square.side = 5;
+	Shape shape;
+	shape.id = 2;
+
+	ByteBuffer buffer;
+	//registered after serializers are created, as AI does with its types
+	buffer.saver.registerType<Shape, Square>();
+	buffer.loader.registerType<Shape, Square>();
+	buffer.saver & std::vector<Shape *>{&square, &shape, &square};
+
+	std::vector<Shape *> loaded;
+	buffer.loader & loaded;
+
+	ASSERT_EQ(loaded.size(), 3);
+	auto loadedSquare = dynamic_cast<Square *>(loaded[0]);
+	ASSERT_TRUE(loadedSquare != nullptr);
+	EXPECT_EQ(loadedSquare->id, 1);
+	EXPECT_EQ(loadedSquare->side, 5);
+	EXPECT_EQ(loaded[1]->id, 2);
+	EXPECT_TRUE(dynamic_cast<Square *>(loaded[1]) == nullptr);
+	EXPECT_EQ(loaded[2], loaded[0]);
+
+	delete loaded[0];
+	delete loaded[1];
+}
+
+#ifndef _MSC_VER
+TEST(BinarySerializerTest, findsTypesByName)
+{
+	typeList.registerType<Shape, Square>();
+
+	Square square;
+	//builds lookup table with relation registered above
+	EXPECT_EQ(typeList.castRaw(&square, &typeid(Square), &typeid(Shape)), static_cast<Shape *>(&square));
+
+	const std::string squareName = typeid(Square).name();
+	const TypeInfoCopy squareType(squareName.c_str());
+	ASSERT_NE(squareType.name(), typeid(Square).name());
+
+	const ui16 typeID = typeList.getTypeID<Square>();
+	EXPECT_NE(typeID, 0);
+	EXPECT_EQ(typeList.getTypeID(&squareType), typeID);
+	EXPECT_EQ(typeList.castRaw(&square, &squareType, &typeid(Shape)), static_cast<Shape *>(&square));
+}
+#endif
+
+TEST(BinarySerializerTest, savegameFilesRoundTrip)
+{
+	const std::vector<si32> numbers(10000, 1337);
+	const std::string text = "text";
+
+	for(bool compressed : {false, true})
+	{
+		for(bool background : {false, true})
+		{
+			const boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("vcmitest-%%%%-%%%%.vsgm1");
+			auto removeFile = vstd::makeScopeGuard([&path]()
+			{
+				boost::filesystem::remove(path);
+			});
+
+			if(background)
+			{
+				CSaveBuffer save;
+				save << numbers << text;
+				save.writeInBackground(path, compressed);
+				EXPECT_EQ(save.getSize(), 0);
+			}
+			else
+			{
+				CSaveFile save(path, compressed);
+				save << numbers << text;
+			}
+
+			std::vector<si32> loadedNumbers;
+			std::string loadedText;
+			{
+				CLoadFile load(path);
+				load >> loadedNumbers >> loadedText;
+			}
+
+			EXPECT_EQ(loadedNumbers, numbers);
+			EXPECT_EQ(loadedText, text);
+
+			if(compressed)
+			{
+				EXPECT_LT(boost::filesystem::file_size(path), numbers.size() * sizeof(si32));
+			}
+
+			boost::filesystem::path tempName = path;
+			tempName += ".tmp";
+			EXPECT_FALSE(boost::filesystem::exists(tempName));
+		}
+	}
+}
@@ -0,0 +1,254 @@
+/*
+ * CConnectionTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include <boost/asio.hpp>
+
+#include "../../lib/serializer/Connection.h"
+#include "../../lib/CConfigHandler.h"
+
+using namespace testing;
+using boost::asio::ip::tcp;
+
+namespace
+{
+	const ui32 COMPRESSED_FLAG = 0x80000000;
+
+	void appendLittleEndian(std::vector<ui8> & out, ui32 value)
+	{
+		for(ui32 i = 0; i < 4; i++)
+			out.push_back(static_cast<ui8>(value >> (8 * i)));
+	}
+
+	ui32 readLittleEndian(const ui8 * in)
+	{
+		ui32 value = 0;
+		for(ui32 i = 0; i < 4; i++)
+			value |= static_cast<ui32>(in[i]) << (8 * i);
+		return value;
+	}
+
+	void appendString(std::vector<ui8> & out, const std::string & text)
+	{
+		appendLittleEndian(out, static_cast<ui32>(text.size()));
+		out.insert(out.end(), text.begin(), text.end());
+	}
+
+	/// Other side of connection which speaks wire protocol directly
+	class RawPeer
+	{
+	public:
+		tcp::socket socket;
+
+		explicit RawPeer(boost::asio::io_service & io)
+			: socket(io)
+		{
+		}
+
+		void sendHandshake(ui32 compressionThreshold)
+		{
+			std::vector<ui8> payload;
+			appendString(payload, "Aiya!\n");
+			appendString(payload, "peer");
+			appendString(payload, "peerUUID");
+			payload.push_back(1); //little endian
+			appendLittleEndian(payload, compressionThreshold);
+
+			std::vector<ui8> frame;
+			appendLittleEndian(frame, static_cast<ui32>(payload.size()));
+			vstd::concatenate(frame, payload);
+			boost::asio::write(socket, boost::asio::buffer(frame));
+		}
+
+		void sendHeader(ui32 sizeField)
+		{
+			std::vector<ui8> header;
+			appendLittleEndian(header, sizeField);
+			boost::asio::write(socket, boost::asio::buffer(header));
+		}
+
+		/// Returns size field of frame header, payload is left as received
+		ui32 receiveFrame(std::vector<ui8> & payload)
+		{
+			ui8 header[4];
+			boost::asio::read(socket, boost::asio::buffer(header));
+			const ui32 sizeField = readLittleEndian(header);
+			payload.resize(sizeField & ~COMPRESSED_FLAG);
+			boost::asio::read(socket, boost::asio::buffer(payload));
+			return sizeField;
+		}
+	};
+}
+
+class CConnectionTest : public Test
+{
+public:
+	std::shared_ptr<boost::asio::io_service> io;
+	std::shared_ptr<TAcceptor> acceptor;
+	si64 oldCompressionThreshold;
+
+	void SetUp() override
+	{
+		io = std::make_shared<boost::asio::io_service>();
+		acceptor = std::make_shared<TAcceptor>(*io, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+		oldCompressionThreshold = settings["server"]["compressionThreshold"].Integer();
+	}
+
+	void TearDown() override
+	{
+		setCompressionThreshold(oldCompressionThreshold);
+	}
+
+	static void setCompressionThreshold(si64 value)
+	{
+		Settings threshold = settings.write["server"]["compressionThreshold"];
+		threshold->Integer() = value;
+	}
+
+	ui16 port() const
+	{
+		return acceptor->local_endpoint().port();
+	}
+
+	/// Both sides make handshake in constructor, so server accepts on other thread
+	void connectPair(std::shared_ptr<CConnection> & server, std::shared_ptr<CConnection> & client)
+	{
+		boost::thread accepting([&]()
+		{
+			server = std::make_shared<CConnection>(acceptor, io, "server", "serverUUID");
+		});
+		client = std::make_shared<CConnection>("127.0.0.1", port(), "client", "clientUUID");
+		accepting.join();
+	}
+
+	std::shared_ptr<CConnection> connectRawPeer(RawPeer & peer, ui32 peerCompressionThreshold)
+	{
+		std::shared_ptr<CConnection> server;
+		boost::thread accepting([&]()
+		{
+			server = std::make_shared<CConnection>(acceptor, io, "server", "serverUUID");
+		});
+		peer.socket.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port()));
+		peer.sendHandshake(peerCompressionThreshold);
+
+		std::vector<ui8> handshake;
+		EXPECT_EQ(peer.receiveFrame(handshake) & COMPRESSED_FLAG, 0);
+		accepting.join();
+		return server;
+	}
+};
+
+TEST_F(CConnectionTest, sendsPlainFrames)
+{
+	setCompressionThreshold(0);
+
+	std::shared_ptr<CConnection> server, client;
+	connectPair(server, client);
+
+	const std::string large(100000, 'x');
+	*client << std::string("small") << large;
+
+	std::string received;
+	*server >> received;
+	EXPECT_EQ(received, "small");
+	*server >> received;
+	EXPECT_EQ(received, large);
+
+	const CConnection::PackTraffic traffic = client->getSentTraffic()[typeid(std::string).name()];
+	EXPECT_EQ(traffic.frames, 2);
+	EXPECT_EQ(traffic.bytes, traffic.rawBytes);
+}
+
+TEST_F(CConnectionTest, compressesLargeFrames)
+{
+	setCompressionThreshold(1000);
+
+	std::shared_ptr<CConnection> server, client;
+	connectPair(server, client);
+
+	const std::string large(100000, 'x');
+	*client << std::string("small") << large << std::string("small again");
+
+	std::string received;
+	*server >> received;
+	EXPECT_EQ(received, "small");
+	*server >> received;
+	EXPECT_EQ(received, large);
+	*server >> received;
+	EXPECT_EQ(received, "small again");
+
+	const CConnection::PackTraffic traffic = client->getSentTraffic()[typeid(std::string).name()];
+	EXPECT_EQ(traffic.frames, 3);
+	EXPECT_LT(traffic.bytes, traffic.rawBytes / 10);
+}
+
+TEST_F(CConnectionTest, compressesOnlyIfBothSidesAllow)
+{
+	setCompressionThreshold(1000);
+
+	const std::string large(100000, 'x');
+	std::vector<ui8> payload;
+
+	{
+		RawPeer peer(*io);
+		auto server = connectRawPeer(peer, 0);
+		*server << large;
+		EXPECT_EQ(peer.receiveFrame(payload) & COMPRESSED_FLAG, 0);
+	}
+	{
+		RawPeer peer(*io);
+		auto server = connectRawPeer(peer, 2000);
+		//larger of thresholds is used
+		*server << std::string(1500, 'x') << large;
+		EXPECT_EQ(peer.receiveFrame(payload) & COMPRESSED_FLAG, 0);
+		EXPECT_NE(peer.receiveFrame(payload) & COMPRESSED_FLAG, 0);
+		EXPECT_EQ(readLittleEndian(payload.data()), large.size() + 4); //uncompressed size includes string length
+	}
+}
+
+TEST_F(CConnectionTest, rejectsOversizedFrames)
+{
+	setCompressionThreshold(1000);
+
+	for(ui32 sizeField : {0x7FFFFFFFu, COMPRESSED_FLAG | 0x7FFFFFFFu})
+	{
+		RawPeer peer(*io);
+		auto server = connectRawPeer(peer, 1000);
+		peer.sendHeader(sizeField);
+
+		std::string received;
+		EXPECT_THROW(*server >> received, std::runtime_error);
+	}
+}
+
+TEST_F(CConnectionTest, dropsStalledReader)
+{
+	setCompressionThreshold(0);
+
+	RawPeer peer(*io);
+	auto server = connectRawPeer(peer, 0);
+	server->enableAsyncSending(1024 * 1024);
+
+	//peer never reads, so once socket buffers are full frames pile up in queue
+	const std::string chunk(256 * 1024, 'x');
+	for(int i = 0; i < 1000 && server->isOpen(); i++)
+	{
+		*server << chunk;
+		boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+	}
+
+	EXPECT_FALSE(server->isOpen());
+	EXPECT_EQ(server->getSendQueueStats().bytes, 0);
+
+	//nothing is left to send, so closing does not wait for timeout
+	const auto start = boost::posix_time::microsec_clock::universal_time();
+	server->close();
+	EXPECT_LT((boost::posix_time::microsec_clock::universal_time() - start).total_milliseconds(), 2000);
+}